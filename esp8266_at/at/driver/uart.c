@@ -29,6 +29,29 @@ extern UartDevice    UartDev;
 
 LOCAL void uart0_rx_intr_handler(void *para);
 
+#define UART_TX_FIFO_SIZE   128
+#define UART_TX_RING_MASK   (UART_TX_RING_SIZE - 1)
+
+/* Filled by uart0_tx_enqueue(), drained by the TXFIFO_EMPTY interrupt.
+ * Both indexes run free; only the writer moves the head, only
+ * uart0_tx_fill() the tail.
+ */
+LOCAL uint8 uart0_txRing[UART_TX_RING_SIZE];
+LOCAL volatile uint16 uart0_txHead;
+LOCAL volatile uint16 uart0_txTail;
+LOCAL uint32 uart0_txStalls;
+
+#define UART_RX_RING_MASK   (UART_RX_RING_SIZE - 1)
+
+/* Filled by the RX interrupt, consumed by at_recvTask; same scheme */
+LOCAL uint8 uart0_rxRing[UART_RX_RING_SIZE];
+LOCAL volatile uint16 uart0_rxHead;
+LOCAL volatile uint16 uart0_rxTail;
+LOCAL volatile bool uart0_rxPosted;
+LOCAL uint32 uart0_rxFifoOvf;
+LOCAL uint32 uart0_rxDropped;
+LOCAL uint16 uart0_rxPeak;
+
 /******************************************************************************
  * FunctionName : uart_config
  * Description  : Internal used function
@@ -50,6 +73,7 @@ uart_config(uint8 uart_no)
     ETS_UART_INTR_ATTACH(uart0_rx_intr_handler,  &(UartDev.rcv_buff));
     PIN_PULLUP_DIS(PERIPHS_IO_MUX_U0TXD_U);
     PIN_FUNC_SELECT(PERIPHS_IO_MUX_U0TXD_U, FUNC_U0TXD);
+    /* RTS on MTDO (GPIO15); the ESP-01 does not bring it out */
     PIN_FUNC_SELECT(PERIPHS_IO_MUX_MTDO_U, FUNC_U0RTS);
   }
 
@@ -74,12 +98,13 @@ uart_config(uint8 uart_no)
     //set rx fifo trigger
     WRITE_PERI_REG(UART_CONF1(uart_no),
                    ((0x10 & UART_RXFIFO_FULL_THRHD) << UART_RXFIFO_FULL_THRHD_S) |
+                   ((UART_TX_EMPTY_THRHD & UART_TXFIFO_EMPTY_THRHD) << UART_TXFIFO_EMPTY_THRHD_S) |
                    ((0x10 & UART_RX_FLOW_THRHD) << UART_RX_FLOW_THRHD_S) |
                    UART_RX_FLOW_EN |
                    (0x02 & UART_RX_TOUT_THRHD) << UART_RX_TOUT_THRHD_S |
                    UART_RX_TOUT_EN);
     SET_PERI_REG_MASK(UART_INT_ENA(uart_no), UART_RXFIFO_TOUT_INT_ENA |
-                      UART_FRM_ERR_INT_ENA);
+                      UART_FRM_ERR_INT_ENA | UART_RXFIFO_OVF_INT_ENA);
   }
   else
   {
@@ -138,9 +163,92 @@ uart1_write_char(char c)
     uart_tx_one_char(UART1, c);
   }
 }
+/******************************************************************************
+ * FunctionName : uart0_tx_fill
+ * Description  : Internal used function
+ *                Move bytes from the TX ring to the TX FIFO, and keep the
+ *                TXFIFO_EMPTY interrupt on while the ring has more.
+ *                Called from the interrupt, or with interrupts locked
+ * Parameters   : NONE
+ * Returns      : NONE
+*******************************************************************************/
+LOCAL void
+uart0_tx_fill(void)
+{
+  uint16 tail = uart0_txTail;
+  uint32 fifo_cnt = (READ_PERI_REG(UART_STATUS(UART0)) >> UART_TXFIFO_CNT_S) & UART_TXFIFO_CNT;
+
+  while ((tail != uart0_txHead) && (fifo_cnt < UART_TX_FIFO_SIZE - 2))
+  {
+    WRITE_PERI_REG(UART_FIFO(UART0), uart0_txRing[tail & UART_TX_RING_MASK]);
+    tail++;
+    fifo_cnt++;
+  }
+  uart0_txTail = tail;
+
+  if (tail != uart0_txHead)
+  {
+    SET_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
+  }
+  else
+  {
+    CLEAR_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
+  }
+  WRITE_PERI_REG(UART_INT_CLR(UART0), UART_TXFIFO_EMPTY_INT_CLR);
+}
+
+/******************************************************************************
+ * FunctionName : uart0_tx_room
+ * Description  : free space in the TX ring; the backpressure signal for
+ *                writers that can hold their data back
+ * Parameters   : NONE
+ * Returns      : bytes uart0_tx_enqueue() takes without waiting
+*******************************************************************************/
+uint16 ICACHE_FLASH_ATTR
+uart0_tx_room(void)
+{
+  return UART_TX_RING_SIZE - (uint16)(uart0_txHead - uart0_txTail);
+}
+
+/******************************************************************************
+ * FunctionName : uart0_tx_enqueue
+ * Description  : queue data on uart0 without waiting
+ * Parameters   : uint8 *buf - point to send buffer
+ *                uint16 len - buffer len
+ * Returns      : bytes queued, less than len if the ring is full
+*******************************************************************************/
+uint16 ICACHE_FLASH_ATTR
+uart0_tx_enqueue(const uint8 *buf, uint16 len)
+{
+  uint16 head = uart0_txHead;
+  uint16 room = uart0_tx_room();
+  uint16 first;
+
+  if (len > room)
+  {
+    len = room;
+  }
+  first = UART_TX_RING_SIZE - (head & UART_TX_RING_MASK);
+  if (first > len)
+  {
+    first = len;
+  }
+  os_memcpy(&uart0_txRing[head & UART_TX_RING_MASK], buf, first);
+  os_memcpy(uart0_txRing, buf + first, len - first);
+
+  /* Publish and start the FIFO; the interrupt takes it from there */
+  ETS_INTR_LOCK();
+  uart0_txHead = head + len;
+  uart0_tx_fill();
+  ETS_INTR_UNLOCK();
+  return len;
+}
+
 /******************************************************************************
  * FunctionName : uart0_tx_buffer
- * Description  : use uart0 to transfer buffer
+ * Description  : use uart0 to transfer buffer. Returns once all of it is
+ *                queued: only when the ring is full does it wait, feeding
+ *                the FIFO itself since the UART interrupt may be masked
  * Parameters   : uint8 *buf - point to send buffer
  *                uint16 len - buffer len
  * Returns      :
@@ -148,34 +256,159 @@ uart1_write_char(char c)
 void ICACHE_FLASH_ATTR
 uart0_tx_buffer(uint8 *buf, uint16 len)
 {
-  uint16 i;
+  uint16 n;
 
-  for (i = 0; i < len; i++)
+  n = uart0_tx_enqueue(buf, len);
+  if (n == len)
   {
-    uart_tx_one_char(UART0, buf[i]);
+    return;
+  }
+
+  uart0_txStalls++;
+  while (n < len)
+  {
+    WRITE_PERI_REG(0X60000914, 0x73); //WTD
+    ETS_INTR_LOCK();
+    uart0_tx_fill();
+    ETS_INTR_UNLOCK();
+    n += uart0_tx_enqueue(buf + n, len - n);
   }
 }
 
 /******************************************************************************
  * FunctionName : uart0_sendStr
- * Description  : use uart0 to transfer buffer
- * Parameters   : uint8 *buf - point to send buffer
- *                uint16 len - buffer len
+ * Description  : use uart0 to transfer string
+ * Parameters   : const char *str - string to send
  * Returns      :
 *******************************************************************************/
 void ICACHE_FLASH_ATTR
 uart0_sendStr(const char *str)
 {
-	while(*str)
-	{
-		uart_tx_one_char(UART0, *str++);
-	}
+  uart0_tx_buffer((uint8 *)str, os_strlen(str));
+}
+
+/******************************************************************************
+ * FunctionName : uart0_tx_flush
+ * Description  : wait until everything queued has left the TX FIFO, before
+ *                a restart or a baud rate change
+ * Parameters   : NONE
+ * Returns      : NONE
+*******************************************************************************/
+void ICACHE_FLASH_ATTR
+uart0_tx_flush(void)
+{
+  while ((uart0_txTail != uart0_txHead)
+         || ((READ_PERI_REG(UART_STATUS(UART0)) >> UART_TXFIFO_CNT_S) & UART_TXFIFO_CNT))
+  {
+    WRITE_PERI_REG(0X60000914, 0x73); //WTD
+    ETS_INTR_LOCK();
+    uart0_tx_fill();
+    ETS_INTR_UNLOCK();
+  }
+}
+
+/******************************************************************************
+ * FunctionName : uart0_tx_stalls
+ * Description  : how often uart0_tx_buffer() found the ring full and waited
+ * Parameters   : NONE
+ * Returns      : count since boot
+*******************************************************************************/
+uint32 ICACHE_FLASH_ATTR
+uart0_tx_stalls(void)
+{
+  return uart0_txStalls;
+}
+
+/******************************************************************************
+ * FunctionName : uart0_rx_drain
+ * Description  : Internal used function, from the ISR or with ETS_INTR_LOCK
+ *                Move the RX FIFO to the RX ring. With no flow control
+ *                to stop the sender, bytes that find the ring full are
+ *                read out and dropped, or the FIFO would overflow anyway
+ * Parameters   : NONE
+ * Returns      : NONE
+*******************************************************************************/
+LOCAL void
+uart0_rx_drain(void)
+{
+  uint16 head = uart0_rxHead;
+  uint16 used;
+  uint8 fifo_cnt = (READ_PERI_REG(UART_STATUS(UART0)) >> UART_RXFIFO_CNT_S) & UART_RXFIFO_CNT;
+
+  while (fifo_cnt--)
+  {
+    uint8 c = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
+
+    if ((uint16)(head - uart0_rxTail) == UART_RX_RING_SIZE)
+    {
+      uart0_rxDropped++;
+      continue;
+    }
+    uart0_rxRing[head & UART_RX_RING_MASK] = c;
+    head++;
+  }
+  uart0_rxHead = head;
+
+  used = head - uart0_rxTail;
+  if (used > uart0_rxPeak)
+  {
+    uart0_rxPeak = used;
+  }
+}
+
+/******************************************************************************
+ * FunctionName : uart0_rx_peek
+ * Description  : received data not consumed yet. Also re-arms the wakeup:
+ *                data that arrives after this call posts at_recvTask again
+ * Parameters   : uint8 **ppData - return the oldest byte in the RX ring
+ * Returns      : bytes readable at *ppData in one piece; after
+ *                uart0_rx_consume() of all of them, the ring may have more
+*******************************************************************************/
+uint16 ICACHE_FLASH_ATTR
+uart0_rx_peek(uint8 **ppData)
+{
+  uint16 tail = uart0_rxTail;
+  uint16 used, first;
+
+  uart0_rxPosted = FALSE;
+  used = uart0_rxHead - tail;
+  first = UART_RX_RING_SIZE - (tail & UART_RX_RING_MASK);
+  *ppData = &uart0_rxRing[tail & UART_RX_RING_MASK];
+  return (used < first) ? used : first;
+}
+
+/******************************************************************************
+ * FunctionName : uart0_rx_consume
+ * Description  : release bytes returned by uart0_rx_peek()
+ * Parameters   : uint16 len - number of bytes done with
+ * Returns      : NONE
+*******************************************************************************/
+void ICACHE_FLASH_ATTR
+uart0_rx_consume(uint16 len)
+{
+  uart0_rxTail += len;
+}
+
+/******************************************************************************
+ * FunctionName : uart0_get_stats
+ * Description  : UART0 error and load counters since boot
+ * Parameters   : UartStats *stats - filled in
+ * Returns      : NONE
+*******************************************************************************/
+void ICACHE_FLASH_ATTR
+uart0_get_stats(UartStats *stats)
+{
+  stats->fifoOverflows = uart0_rxFifoOvf;
+  stats->rxDropped = uart0_rxDropped;
+  stats->ringPeak = uart0_rxPeak;
+  stats->txStalls = uart0_txStalls;
 }
 
 /******************************************************************************
  * FunctionName : uart0_rx_intr_handler
  * Description  : Internal used function
- *                UART0 interrupt handler, add self handle code inside
+ *                UART0 interrupt handler: refills the TX FIFO from the ring,
+ *                hands received data to at_recvTask
  * Parameters   : void *para - point to ETS_UART_INTR_ATTACH's arg
  * Returns      : NONE
 *******************************************************************************/
@@ -202,18 +435,33 @@ uart0_rx_intr_handler(void *para)
 //    system_os_post(at_recvTaskPrio, NULL, RcvChar);
 //    WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_FULL_INT_CLR);
 //  }
+  if(UART_TXFIFO_EMPTY_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_TXFIFO_EMPTY_INT_ST))
+  {
+    uart0_tx_fill();
+  }
+
   if(UART_FRM_ERR_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_FRM_ERR_INT_ST))
   {
     os_printf("FRM_ERR\r\n");
     WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_FRM_ERR_INT_CLR);
   }
 
-  if(UART_RXFIFO_FULL_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_FULL_INT_ST))
+  if(UART_RXFIFO_OVF_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_OVF_INT_ST))
   {
-//    os_printf("fifo full\r\n");
-    ETS_UART_INTR_DISABLE();/////////
+    uart0_rxFifoOvf++;
+    WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_OVF_INT_CLR);
+  }
 
-    system_os_post(at_recvTaskPrio, 0, 0);
+  if(READ_PERI_REG(UART_INT_ST(uart_no)) & (UART_RXFIFO_FULL_INT_ST | UART_RXFIFO_TOUT_INT_ST))
+  {
+    /* Empty the FIFO now, so the task may run late without losing data */
+    uart0_rx_drain();
+    WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_FULL_INT_CLR | UART_RXFIFO_TOUT_INT_CLR);
+    if(!uart0_rxPosted)
+    {
+      uart0_rxPosted = TRUE;
+      system_os_post(at_recvTaskPrio, 0, 0);
+    }
 
 //    WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_FULL_INT_CLR);
 //    while (READ_PERI_REG(UART_STATUS(uart_no)) & (UART_RXFIFO_CNT << UART_RXFIFO_CNT_S))
@@ -223,13 +471,8 @@ uart0_rx_intr_handler(void *para)
 //      system_os_post(at_recvTaskPrio, NULL, RcvChar);
 //    }
   }
-  else if(UART_RXFIFO_TOUT_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_TOUT_INT_ST))
-  {
-    ETS_UART_INTR_DISABLE();/////////
-
-//    os_printf("stat:%02X",*(uint8 *)UART_INT_ENA(uart_no));
-    system_os_post(at_recvTaskPrio, 0, 0);
-
+//  else if(UART_RXFIFO_TOUT_INT_ST == (READ_PERI_REG(UART_INT_ST(uart_no)) & UART_RXFIFO_TOUT_INT_ST))
+//  {
 //    WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_TOUT_INT_CLR);
 ////    os_printf("rx time over\r\n");
 //    while (READ_PERI_REG(UART_STATUS(uart_no)) & (UART_RXFIFO_CNT << UART_RXFIFO_CNT_S))
@@ -239,7 +482,7 @@ uart0_rx_intr_handler(void *para)
 //      RcvChar = READ_PERI_REG(UART_FIFO(uart_no)) & 0xFF;
 //      system_os_post(at_recvTaskPrio, NULL, RcvChar);
 //    }
-  }
+//  }
 
 //  WRITE_PERI_REG(UART_INT_CLR(uart_no), UART_RXFIFO_FULL_INT_CLR);
 
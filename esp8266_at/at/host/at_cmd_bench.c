@@ -0,0 +1,148 @@
+/*
+ * File	: at_cmd_bench.c
+ * Host microbenchmark of the AT command lookup.
+ *
+ * Times at_cmdParse() against the linear search it replaced (kept here as
+ * the reference) on every command of at_fun[] in each of its forms, plus
+ * some lines that match nothing. Both must agree on every line.
+ *
+ *   at_cmd_bench [ROUNDS]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "osapi.h"
+#include "at.h"
+
+#define at_cmdNum   32        /* as in at_cmd.h, which defines at_fun[] */
+
+extern at_funcationType at_fun[];
+
+static const char *unknown[] = {
+  "+FOO\r\n", "+CIPSTARX=1\r\n", "+CWMODEX?\r\n", "+CIPSTATUSES\r\n",
+  "+ABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n",
+};
+
+/* at_getCmdLen() and at_cmdSearch() before the hash */
+static int8_t
+at_getCmdLenLinear(uint8_t *pCmd)
+{
+  uint8_t n, i;
+
+  n = 0;
+  i = 128;
+  while (i--)
+  {
+    if ((*pCmd == '\r') || (*pCmd == '=') || (*pCmd == '?') || ((*pCmd >= '0') && (*pCmd <= '9')))
+    {
+      return n;
+    }
+    pCmd++;
+    n++;
+  }
+  return -1;
+}
+
+static int16_t
+at_cmdSearchLinear(uint8_t *pCmd, int8_t *pCmdLen)
+{
+  int8_t cmdLen = at_getCmdLenLinear(pCmd);
+  int16_t i;
+
+  *pCmdLen = cmdLen;
+  if (cmdLen == 0)
+  {
+    return 0;
+  }
+  if (cmdLen > 0)
+  {
+    for (i = 1; i < at_cmdNum; i++)
+    {
+      if (cmdLen == at_fun[i].at_cmdLen && os_memcmp(pCmd, at_fun[i].at_cmdName, cmdLen) == 0)
+      {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Average ns per lookup of one line, over rounds */
+static double
+bench(int16_t (*lookup)(uint8_t *, int8_t *), uint8_t *line, long rounds, volatile int16_t *sink)
+{
+  double t0 = now_ns();
+  int8_t len;
+  long r;
+
+  for (r = 0; r < rounds; r++)
+  {
+    *sink += lookup(line, &len);
+  }
+  return (now_ns() - t0) / rounds;
+}
+
+int
+main(int argc, char **argv)
+{
+  static uint8_t lines[3 * at_cmdNum + 8][160];
+  static const char *forms[] = { "\r\n", "?\r\n", "=1,\"x\",80\r\n" };
+  long rounds = argc > 1 ? atol(argv[1]) : 200000;
+  volatile int16_t sink = 0;
+  double sum_linear = 0, sum_hash = 0, max_linear = 0, max_hash = 0;
+  int cnt = 0, i, f;
+
+  for (i = 1; i < at_cmdNum; i++)
+  {
+    if (at_fun[i].at_cmdName == NULL)
+    {
+      continue;
+    }
+    for (f = 0; f < 3; f++)
+    {
+      snprintf((char *)lines[cnt++], sizeof(lines[0]), "%s%s", at_fun[i].at_cmdName, forms[f]);
+    }
+  }
+  for (i = 0; i < (int)(sizeof(unknown) / sizeof(unknown[0])); i++)
+  {
+    snprintf((char *)lines[cnt++], sizeof(lines[0]), "%s", unknown[i]);
+  }
+
+  for (i = 0; i < cnt; i++)
+  {
+    int8_t len_linear, len_hash;
+    int16_t id_linear = at_cmdSearchLinear(lines[i], &len_linear);
+    int16_t id_hash = at_cmdParse(lines[i], &len_hash);
+    double t;
+
+    if (id_linear != id_hash || (id_hash != -1 && len_linear != len_hash))
+    {
+      fprintf(stderr, "mismatch on \"%.*s\": linear %d, hash %d\n",
+              (int)strcspn((char *)lines[i], "\r"), lines[i], id_linear, id_hash);
+      return 1;
+    }
+
+    t = bench(at_cmdSearchLinear, lines[i], rounds, &sink);
+    sum_linear += t;
+    max_linear = t > max_linear ? t : max_linear;
+    t = bench(at_cmdParse, lines[i], rounds, &sink);
+    sum_hash += t;
+    max_hash = t > max_hash ? t : max_hash;
+  }
+
+  printf("%d lines, %ld rounds each\n", cnt, rounds);
+  printf("  linear: %6.1f ns/lookup average, %6.1f ns worst\n", sum_linear / cnt, max_linear);
+  printf("  hash:   %6.1f ns/lookup average, %6.1f ns worst\n", sum_hash / cnt, max_hash);
+  return 0;
+}
@@ -0,0 +1,609 @@
+/*
+ * File	: espconn_host.c
+ * Host build of the AT firmware: espconn API of the NONOS SDK on BSD sockets.
+ *
+ * Each espconn with a socket has a record here. Callbacks arrive from the
+ * main loop as they do from lwIP on the chip, never from inside the
+ * espconn_* call that caused them: a send completes when the socket takes
+ * the last byte, a disconnect on the next loop pass. The firmware may free
+ * the espconn from a callback, so a record is dropped before its callback
+ * runs.
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "osapi.h"
+#include "espconn.h"
+#include "host.h"
+
+#define ESPCONN_HOST_MAX    8
+#define ESPCONN_HOST_MSS    1460
+
+struct espconn_host {
+  struct espconn *pespconn;     /* NULL when the slot is free */
+  int fd;
+  bool connecting;
+  bool listening;
+  bool accepted;                /* espconn allocated here by accept() */
+  uint8 *tx;                    /* data of the espconn_sent() in flight */
+  uint16 tx_len;
+  uint16 tx_off;
+};
+
+struct espconn_defer {
+  os_timer_t timer;
+  struct espconn *pespconn;
+  espconn_connect_callback cb;
+  dns_found_callback found;
+  ip_addr_t ip;
+  bool resolved;
+  char name[64];
+};
+
+static struct espconn_host conns[ESPCONN_HOST_MAX];
+
+static void espconn_host_io(int fd, short revents, void *arg);
+
+static struct espconn_host *
+espconn_host_find(struct espconn *pespconn)
+{
+  int i;
+
+  for (i = 0; i < ESPCONN_HOST_MAX; i++)
+  {
+    if (conns[i].pespconn == pespconn)
+    {
+      return &conns[i];
+    }
+  }
+  return NULL;
+}
+
+static struct espconn_host *
+espconn_host_alloc(struct espconn *pespconn, int fd)
+{
+  struct espconn_host *c = espconn_host_find(NULL);
+
+  if (c == NULL)
+  {
+    return NULL;
+  }
+  os_memset(c, 0, sizeof(*c));
+  c->pespconn = pespconn;
+  c->fd = fd;
+  return c;
+}
+
+/* Closes the socket and frees the slot; the espconn is left alone */
+static void
+espconn_host_drop(struct espconn_host *c)
+{
+  host_unwatch(c->fd);
+  close(c->fd);
+  free(c->tx);
+  c->tx = NULL;
+  c->pespconn = NULL;
+}
+
+static void
+espconn_host_update(struct espconn_host *c)
+{
+  short events = POLLIN;
+
+  if (c->connecting || c->tx != NULL)
+  {
+    events |= POLLOUT;
+  }
+  host_watch(c->fd, events, espconn_host_io, c);
+}
+
+static int
+espconn_host_socket(int type)
+{
+  int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int one = 1;
+
+  if (fd >= 0)
+  {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (type == SOCK_STREAM)
+    {
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+  }
+  return fd;
+}
+
+static void
+espconn_host_sockaddr(struct sockaddr_in *sa, const uint8 *ip, int port)
+{
+  os_memset(sa, 0, sizeof(*sa));
+  sa->sin_family = AF_INET;
+  sa->sin_port = htons(port);
+  if (ip != NULL)
+  {
+    os_memcpy(&sa->sin_addr.s_addr, ip, 4);
+  }
+}
+
+static void
+espconn_host_deferred(void *arg)
+{
+  struct espconn_defer *d = arg;
+
+  if (d->found != NULL)
+  {
+    d->found(d->name, d->resolved ? &d->ip : NULL, d->pespconn);
+  }
+  else if (d->cb != NULL)
+  {
+    d->cb(d->pespconn);
+  }
+  free(d);
+}
+
+static void
+espconn_host_defer(struct espconn_defer *d)
+{
+  os_timer_setfn(&d->timer, espconn_host_deferred, d);
+  os_timer_arm(&d->timer, 0, 0);
+}
+
+/******************************************************************************
+ * Socket events
+*******************************************************************************/
+
+static void
+espconn_host_accept(struct espconn_host *l)
+{
+  struct sockaddr_in sa;
+  socklen_t sa_len = sizeof(sa);
+  struct espconn *pespconn;
+  struct espconn_host *c;
+  int fd, one = 1;
+
+  fd = accept4(l->fd, (struct sockaddr *)&sa, &sa_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0)
+  {
+    return;
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  pespconn = calloc(1, sizeof(*pespconn));
+  pespconn->proto.tcp = calloc(1, sizeof(esp_tcp));
+  c = espconn_host_alloc(pespconn, fd);
+  if (c == NULL)
+  {
+    free(pespconn->proto.tcp);
+    free(pespconn);
+    close(fd);
+    return;
+  }
+  c->accepted = true;
+  pespconn->type = ESPCONN_TCP;
+  pespconn->state = ESPCONN_CONNECT;
+  pespconn->proto.tcp->local_port = l->pespconn->proto.tcp->local_port;
+  pespconn->proto.tcp->remote_port = ntohs(sa.sin_port);
+  os_memcpy(pespconn->proto.tcp->remote_ip, &sa.sin_addr.s_addr, 4);
+  espconn_host_update(c);
+
+  if (l->pespconn->proto.tcp->connect_callback != NULL)
+  {
+    l->pespconn->proto.tcp->connect_callback(pespconn);
+  }
+}
+
+static void
+espconn_host_connected(struct espconn_host *c)
+{
+  struct espconn *pespconn = c->pespconn;
+  int err = 0;
+  socklen_t len = sizeof(err);
+
+  getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+  if (err != 0)
+  {
+    espconn_reconnect_callback cb = pespconn->proto.tcp->reconnect_callback;
+
+    espconn_host_drop(c);
+    pespconn->state = ESPCONN_CLOSE;
+    if (cb != NULL)
+    {
+      cb(pespconn, err == ETIMEDOUT ? ESPCONN_TIMEOUT : ESPCONN_CONN);
+    }
+    return;
+  }
+
+  c->connecting = false;
+  pespconn->state = ESPCONN_CONNECT;
+  espconn_host_update(c);
+  if (pespconn->proto.tcp->connect_callback != NULL)
+  {
+    pespconn->proto.tcp->connect_callback(pespconn);
+  }
+}
+
+static void
+espconn_host_closed(struct espconn_host *c, bool reset)
+{
+  struct espconn *pespconn = c->pespconn;
+  bool accepted = c->accepted;
+
+  espconn_host_drop(c);
+  pespconn->state = ESPCONN_CLOSE;
+  if (reset)
+  {
+    if (pespconn->proto.tcp->reconnect_callback != NULL)
+    {
+      pespconn->proto.tcp->reconnect_callback(pespconn, ESPCONN_RST);
+    }
+  }
+  else if (pespconn->proto.tcp->disconnect_callback != NULL)
+  {
+    pespconn->proto.tcp->disconnect_callback(pespconn);
+  }
+  if (accepted)
+  {
+    free(pespconn->proto.tcp);
+    free(pespconn);
+  }
+}
+
+static void
+espconn_host_readable(struct espconn_host *c)
+{
+  struct espconn *pespconn = c->pespconn;
+  char buf[ESPCONN_HOST_MSS];
+  ssize_t n;
+
+  if (pespconn->type == ESPCONN_UDP)
+  {
+    struct sockaddr_in sa;
+    socklen_t sa_len = sizeof(sa);
+
+    n = recvfrom(c->fd, buf, sizeof(buf), 0, (struct sockaddr *)&sa, &sa_len);
+    if (n < 0)
+    {
+      return;
+    }
+    /* The SDK reports the sender in the espconn */
+    pespconn->proto.udp->remote_port = ntohs(sa.sin_port);
+    os_memcpy(pespconn->proto.udp->remote_ip, &sa.sin_addr.s_addr, 4);
+  }
+  else
+  {
+    n = recv(c->fd, buf, sizeof(buf), 0);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+    {
+      return;
+    }
+    if (n <= 0)
+    {
+      espconn_host_closed(c, n < 0);
+      return;
+    }
+  }
+  if (pespconn->recv_callback != NULL)
+  {
+    pespconn->recv_callback(pespconn, buf, (unsigned short)n);
+  }
+}
+
+static void
+espconn_host_writable(struct espconn_host *c)
+{
+  struct espconn *pespconn = c->pespconn;
+
+  if (pespconn->type == ESPCONN_TCP)
+  {
+    ssize_t n = send(c->fd, c->tx + c->tx_off, c->tx_len - c->tx_off, MSG_NOSIGNAL);
+
+    if (n < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+      {
+        espconn_host_closed(c, true);
+      }
+      return;
+    }
+    c->tx_off += n;
+    if (c->tx_off < c->tx_len)
+    {
+      return;
+    }
+  }
+  else
+  {
+    struct sockaddr_in sa;
+
+    espconn_host_sockaddr(&sa, pespconn->proto.udp->remote_ip, pespconn->proto.udp->remote_port);
+    sendto(c->fd, c->tx, c->tx_len, 0, (struct sockaddr *)&sa, sizeof(sa));
+  }
+
+  free(c->tx);
+  c->tx = NULL;
+  pespconn->state = ESPCONN_CONNECT;
+  espconn_host_update(c);
+  if (pespconn->sent_callback != NULL)
+  {
+    pespconn->sent_callback(pespconn);
+  }
+}
+
+static void
+espconn_host_io(int fd, short revents, void *arg)
+{
+  struct espconn_host *c = arg;
+
+  /* An earlier callback of this loop pass may have closed the link */
+  if (c->pespconn == NULL || c->fd != fd)
+  {
+    return;
+  }
+  if (c->listening)
+  {
+    espconn_host_accept(c);
+  }
+  else if (c->connecting)
+  {
+    espconn_host_connected(c);
+  }
+  else if (revents & (POLLIN | POLLHUP | POLLERR))
+  {
+    espconn_host_readable(c);
+  }
+  else if ((revents & POLLOUT) && c->tx != NULL)
+  {
+    espconn_host_writable(c);
+  }
+}
+
+/******************************************************************************
+ * espconn API
+*******************************************************************************/
+
+sint8
+espconn_create(struct espconn *espconn)
+{
+  struct sockaddr_in sa;
+  struct espconn_host *c;
+  int fd;
+
+  if (espconn->type != ESPCONN_UDP || espconn_host_find(espconn) != NULL)
+  {
+    return ESPCONN_ISCONN;
+  }
+  fd = espconn_host_socket(SOCK_DGRAM);
+  espconn_host_sockaddr(&sa, NULL, espconn->proto.udp->local_port);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return ESPCONN_MEM;
+  }
+  c = espconn_host_alloc(espconn, fd);
+  if (c == NULL)
+  {
+    close(fd);
+    return ESPCONN_MEM;
+  }
+  espconn_host_update(c);
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_connect(struct espconn *espconn)
+{
+  struct sockaddr_in sa;
+  struct espconn_host *c;
+  int fd;
+
+  if (espconn->type == ESPCONN_UDP)
+  {
+    return espconn_create(espconn);
+  }
+  if (espconn_host_find(espconn) != NULL)
+  {
+    return ESPCONN_ISCONN;
+  }
+  fd = espconn_host_socket(SOCK_STREAM);
+  if (fd < 0)
+  {
+    return ESPCONN_MEM;
+  }
+  c = espconn_host_alloc(espconn, fd);
+  if (c == NULL)
+  {
+    close(fd);
+    return ESPCONN_MEM;
+  }
+
+  /* The outcome, even an immediate refusal, reaches the firmware by callback */
+  espconn_host_sockaddr(&sa, espconn->proto.tcp->remote_ip, espconn->proto.tcp->remote_port);
+  connect(fd, (struct sockaddr *)&sa, sizeof(sa));
+  c->connecting = true;
+  espconn->state = ESPCONN_WAIT;
+  espconn_host_update(c);
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_sent(struct espconn *espconn, uint8 *psent, uint16 length)
+{
+  struct espconn_host *c = espconn_host_find(espconn);
+
+  if (c == NULL || c->connecting || c->listening)
+  {
+    return ESPCONN_ARG;
+  }
+  if (c->tx != NULL)
+  {
+    return ESPCONN_INPROGRESS;
+  }
+  c->tx = malloc(length ? length : 1);
+  os_memcpy(c->tx, psent, length);
+  c->tx_len = length;
+  c->tx_off = 0;
+  espconn->state = ESPCONN_WRITE;
+  espconn_host_update(c);
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_disconnect(struct espconn *espconn)
+{
+  struct espconn_host *c = espconn_host_find(espconn);
+  struct espconn_defer *d;
+
+  if (c == NULL || espconn->type != ESPCONN_TCP)
+  {
+    return ESPCONN_ARG;
+  }
+  espconn_host_drop(c);
+  espconn->state = ESPCONN_CLOSE;
+
+  d = calloc(1, sizeof(*d));
+  d->pespconn = espconn;
+  d->cb = espconn->proto.tcp->disconnect_callback;
+  espconn_host_defer(d);
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_delete(struct espconn *espconn)
+{
+  struct espconn_host *c = espconn_host_find(espconn);
+
+  if (c == NULL)
+  {
+    return ESPCONN_ARG;
+  }
+  espconn_host_drop(c);
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_accept(struct espconn *espconn)
+{
+  struct sockaddr_in sa;
+  struct espconn_host *c;
+  int fd;
+
+  if (espconn->type != ESPCONN_TCP || espconn_host_find(espconn) != NULL)
+  {
+    return ESPCONN_ISCONN;
+  }
+  fd = espconn_host_socket(SOCK_STREAM);
+  espconn_host_sockaddr(&sa, NULL, espconn->proto.tcp->local_port);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(fd, 4) < 0)
+  {
+    os_printf("espconn_accept: port %d: %s\n", espconn->proto.tcp->local_port, strerror(errno));
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return ESPCONN_MEM;
+  }
+  c = espconn_host_alloc(espconn, fd);
+  if (c == NULL)
+  {
+    close(fd);
+    return ESPCONN_MEM;
+  }
+  c->listening = true;
+  espconn->state = ESPCONN_LISTEN;
+  espconn_host_update(c);
+  return ESPCONN_OK;
+}
+
+/* Idle links are not timed out on the host */
+sint8
+espconn_regist_time(struct espconn *espconn, uint32 interval, uint8 type_flag)
+{
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_regist_sentcb(struct espconn *espconn, espconn_sent_callback sent_cb)
+{
+  espconn->sent_callback = sent_cb;
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_regist_recvcb(struct espconn *espconn, espconn_recv_callback recv_cb)
+{
+  espconn->recv_callback = recv_cb;
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_regist_connectcb(struct espconn *espconn, espconn_connect_callback connect_cb)
+{
+  espconn->proto.tcp->connect_callback = connect_cb;
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_regist_reconcb(struct espconn *espconn, espconn_reconnect_callback recon_cb)
+{
+  espconn->proto.tcp->reconnect_callback = recon_cb;
+  return ESPCONN_OK;
+}
+
+sint8
+espconn_regist_disconcb(struct espconn *espconn, espconn_connect_callback discon_cb)
+{
+  espconn->proto.tcp->disconnect_callback = discon_cb;
+  return ESPCONN_OK;
+}
+
+uint32
+espconn_port(void)
+{
+  static uint32 port;
+
+  if (port == 0)
+  {
+    port = 1024 + (getpid() % 20000);
+  }
+  return ++port;
+}
+
+err_t
+espconn_gethostbyname(struct espconn *pespconn, const char *hostname, ip_addr_t *addr,
+                      dns_found_callback found)
+{
+  struct addrinfo hints = { .ai_family = AF_INET }, *res;
+  struct espconn_defer *d;
+
+  addr->addr = ipaddr_addr(hostname);
+  if (addr->addr != IPADDR_NONE)
+  {
+    return ESPCONN_OK;
+  }
+  addr->addr = 0;
+
+  /* Resolved at once, but answered later as lwIP's DNS client does */
+  d = calloc(1, sizeof(*d));
+  d->pespconn = pespconn;
+  d->found = found;
+  os_strncpy(d->name, hostname, sizeof(d->name) - 1);
+  if (getaddrinfo(hostname, NULL, &hints, &res) == 0)
+  {
+    d->ip.addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr;
+    d->resolved = true;
+    freeaddrinfo(res);
+  }
+  espconn_host_defer(d);
+  return ESPCONN_INPROGRESS;
+}
@@ -0,0 +1,52 @@
+/*
+ * File	: host.h
+ * Host build of the AT firmware: glue between the mock SDK modules.
+ *
+ * The firmware runs single-threaded, as on the chip: host_run() is the
+ * SDK main loop. It takes the UART interrupt, then runs one posted task
+ * event (highest priority first) or due timers, and otherwise waits in
+ * poll() on the PTY and the espconn sockets.
+ */
+#ifndef __HOST_H
+#define __HOST_H
+
+#include <poll.h>
+
+#include "c_types.h"
+
+typedef void (*host_fd_cb_t)(int fd, short revents, void *arg);
+
+/* sdk_host.c */
+void host_sdk_init(void);
+uint32 host_ms(void);
+uint64_t host_us(void);
+void host_watch(int fd, short events, host_fd_cb_t cb, void *arg);
+void host_unwatch(int fd);
+void host_irq_check(void);
+void host_run(void);
+void host_print_stats(void);
+
+struct host_options {
+  const char *pty_path;     /* attach here instead of creating a PTY */
+  const char *flash_path;   /* flash image, kept across runs */
+  uint32 baud;              /* line pacing; 0 moves bytes as fast as they come */
+  uint32 join_ms;           /* station gets an IP this long after connecting */
+  uint32 heap_size;         /* os_malloc() fails beyond this */
+  int uart_fd;              /* PTY inherited across system_restart() */
+};
+
+extern struct host_options host_opt;
+extern char **host_argv;
+
+/* uart_host.c */
+int uart_host_open(void);
+void uart_host_poll(void);
+int uart_host_timeout_ms(void);
+bool uart_host_irq_pending(void);
+void uart_host_flush(void);
+void uart_host_print_stats(void);
+
+/* wifi_host.c */
+void wifi_host_init(void);
+
+#endif /* __HOST_H */
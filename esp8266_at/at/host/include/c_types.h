@@ -0,0 +1,66 @@
+/*
+ * Host build: basic types of the ESP8266 NONOS SDK.
+ */
+#ifndef _C_TYPES_H_
+#define _C_TYPES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t             uint8;
+typedef uint8_t             u8;
+typedef int8_t              sint8;
+typedef int8_t              int8;
+typedef int8_t              s8;
+typedef uint16_t            uint16;
+typedef uint16_t            u16;
+typedef int16_t             sint16;
+typedef int16_t             s16;
+typedef uint32_t            uint32;
+typedef uint32_t            u32;
+typedef int32_t             sint32;
+typedef int32_t             s32;
+typedef int32_t             int32;
+typedef int64_t             sint64;
+typedef uint64_t            uint64;
+typedef uint64_t            u64;
+typedef float               real32;
+typedef double              real64;
+
+#define __le16      u16
+
+#define __packed        __attribute__((packed))
+
+#define LOCAL       static
+
+#ifndef NULL
+#define NULL (void *)0
+#endif
+
+typedef enum {
+    OK = 0,
+    FAIL,
+    PENDING,
+    BUSY,
+    CANCEL,
+} STATUS;
+
+#define BIT(nr)                 (1UL << (nr))
+
+#define DMEM_ATTR
+#define SHMEM_ATTR
+
+/* No flash/IRAM split on the host */
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RODATA_ATTR
+
+#ifndef __cplusplus
+typedef unsigned char   bool;
+#define BOOL            bool
+#define true            (1)
+#define false           (0)
+#define TRUE            true
+#define FALSE           false
+#endif
+
+#endif /* _C_TYPES_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Host build: peripheral register access.
+ *
+ * Registers are not memory on the host. Every access goes to the
+ * peripheral model in host/uart_host.c, so the UART driver and the AT port
+ * layer run unchanged against it.
+ */
+#ifndef _EAGLE_SOC_H_
+#define _EAGLE_SOC_H_
+
+#include "c_types.h"
+
+#define BIT31   0x80000000
+#define BIT30   0x40000000
+#define BIT29   0x20000000
+#define BIT28   0x10000000
+#define BIT27   0x08000000
+#define BIT26   0x04000000
+#define BIT25   0x02000000
+#define BIT24   0x01000000
+#define BIT23   0x00800000
+#define BIT22   0x00400000
+#define BIT21   0x00200000
+#define BIT20   0x00100000
+#define BIT19   0x00080000
+#define BIT18   0x00040000
+#define BIT17   0x00020000
+#define BIT16   0x00010000
+#define BIT15   0x00008000
+#define BIT14   0x00004000
+#define BIT13   0x00002000
+#define BIT12   0x00001000
+#define BIT11   0x00000800
+#define BIT10   0x00000400
+#define BIT9    0x00000200
+#define BIT8    0x00000100
+#define BIT7    0x00000080
+#define BIT6    0x00000040
+#define BIT5    0x00000020
+#define BIT4    0x00000010
+#define BIT3    0x00000008
+#define BIT2    0x00000004
+#define BIT1    0x00000002
+#define BIT0    0x00000001
+
+#define UART_CLK_FREQ   (80 * 1000000)
+
+uint32 host_reg_read(uint32 addr);
+void host_reg_write(uint32 addr, uint32 val);
+
+#define READ_PERI_REG(addr)             host_reg_read((uint32)(addr))
+#define WRITE_PERI_REG(addr, val)       host_reg_write((uint32)(addr), (uint32)(val))
+#define CLEAR_PERI_REG_MASK(reg, mask)  WRITE_PERI_REG((reg), (READ_PERI_REG(reg) & (~(mask))))
+#define SET_PERI_REG_MASK(reg, mask)    WRITE_PERI_REG((reg), (READ_PERI_REG(reg) | (mask)))
+#define GET_PERI_REG_BITS(reg, hipos, lowpos) \
+    ((READ_PERI_REG(reg) >> (lowpos)) & ((1 << ((hipos) - (lowpos) + 1)) - 1))
+#define SET_PERI_REG_BITS(reg, bit_map, value, shift) \
+    (WRITE_PERI_REG((reg), (READ_PERI_REG(reg) & (~((bit_map) << (shift)))) | ((value) << (shift))))
+
+/* Pin muxing has nothing to do on the host */
+#define PERIPHS_IO_MUX_MTDO_U           0
+#define PERIPHS_IO_MUX_U0TXD_U          0
+#define PERIPHS_IO_MUX_GPIO2_U          0
+#define FUNC_U0RTS                      4
+#define FUNC_U0TXD                      0
+#define FUNC_U1TXD_BK                   2
+#define PIN_PULLUP_DIS(PIN_NAME)        ((void)(PIN_NAME))
+#define PIN_PULLUP_EN(PIN_NAME)         ((void)(PIN_NAME))
+#define PIN_FUNC_SELECT(PIN_NAME, FUNC) ((void)(PIN_NAME), (void)(FUNC))
+
+#endif /* _EAGLE_SOC_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Host build: ROM services of the ESP8266 NONOS SDK.
+ */
+#ifndef _ETS_SYS_H
+#define _ETS_SYS_H
+
+#include "c_types.h"
+#include "eagle_soc.h"
+
+typedef uint32_t ETSSignal;
+typedef uint32_t ETSParam;
+
+typedef struct ETSEventTag ETSEvent;
+
+struct ETSEventTag {
+    ETSSignal sig;
+    ETSParam  par;
+};
+
+typedef void (*ETSTask)(ETSEvent *e);
+
+typedef void ETSTimerFunc(void *timer_arg);
+
+typedef struct _ETSTIMER_ {
+    struct _ETSTIMER_    *timer_next;
+    uint32_t              timer_expire;
+    uint32_t              timer_period;
+    ETSTimerFunc         *timer_func;
+    void                 *timer_arg;
+} ETSTimer;
+
+typedef void (*int_handler_t)(void *);
+
+#define ETS_UART_INUM       5
+
+/* One interrupt line, as on the chip; host/uart_host.c raises it */
+void ets_isr_attach(int i, int_handler_t func, void *arg);
+void ets_isr_mask(unsigned intr);
+void ets_isr_unmask(unsigned intr);
+
+#define ETS_UART_INTR_ATTACH(func, arg) \
+    ets_isr_attach(ETS_UART_INUM, (int_handler_t)(func), (void *)(arg))
+#define ETS_UART_INTR_ENABLE()          ets_isr_unmask(1 << ETS_UART_INUM)
+#define ETS_UART_INTR_DISABLE()         ets_isr_mask(1 << ETS_UART_INUM)
+
+/* All interrupts off, nesting */
+void ets_intr_lock(void);
+void ets_intr_unlock(void);
+
+#define ETS_INTR_LOCK()                 ets_intr_lock()
+#define ETS_INTR_UNLOCK()               ets_intr_unlock()
+
+void uart_div_modify(uint8 uart_no, uint32 DivLatchValue);
+void ets_delay_us(uint32_t us);
+
+#endif /* _ETS_SYS_H */
@@ -0,0 +1,42 @@
+/*
+ * Host build: lwIP address helpers used by the NONOS SDK API.
+ */
+#ifndef __IP_ADDR_H__
+#define __IP_ADDR_H__
+
+#include "c_types.h"
+
+struct ip_addr {
+    uint32 addr;
+};
+
+typedef struct ip_addr ip_addr_t;
+
+struct ip_info {
+    struct ip_addr ip;
+    struct ip_addr netmask;
+    struct ip_addr gw;
+};
+
+#define IPADDR_NONE     ((uint32)0xffffffffUL)
+
+uint32 ipaddr_addr(const char *cp);
+
+#define ip4_addr1(ipaddr) (((uint8 *)(ipaddr))[0])
+#define ip4_addr2(ipaddr) (((uint8 *)(ipaddr))[1])
+#define ip4_addr3(ipaddr) (((uint8 *)(ipaddr))[2])
+#define ip4_addr4(ipaddr) (((uint8 *)(ipaddr))[3])
+
+#define ip4_addr1_16(ipaddr) ((uint16)ip4_addr1(ipaddr))
+#define ip4_addr2_16(ipaddr) ((uint16)ip4_addr2(ipaddr))
+#define ip4_addr3_16(ipaddr) ((uint16)ip4_addr3(ipaddr))
+#define ip4_addr4_16(ipaddr) ((uint16)ip4_addr4(ipaddr))
+
+#define IP2STR(ipaddr) ip4_addr1_16(ipaddr), \
+    ip4_addr2_16(ipaddr), \
+    ip4_addr3_16(ipaddr), \
+    ip4_addr4_16(ipaddr)
+
+#define IPSTR "%d.%d.%d.%d"
+
+#endif /* __IP_ADDR_H__ */
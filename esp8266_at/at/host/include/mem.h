@@ -0,0 +1,16 @@
+/*
+ * Host build: heap of the NONOS SDK, with usage accounting.
+ */
+#ifndef __MEM_H__
+#define __MEM_H__
+
+#include "c_types.h"
+
+void *host_malloc(size_t size, bool zero);
+void host_free(void *p);
+
+#define os_malloc(s)    host_malloc((s), false)
+#define os_zalloc(s)    host_malloc((s), true)
+#define os_free(p)      host_free(p)
+
+#endif /* __MEM_H__ */
@@ -0,0 +1,46 @@
+/*
+ * Host build: libc-style helpers and software timers of the NONOS SDK.
+ */
+#ifndef _OSAPI_H_
+#define _OSAPI_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "os_type.h"
+#include "user_config.h"
+
+#define os_bzero(s, n)          memset(s, 0, n)
+#define os_delay_us             ets_delay_us
+#define os_install_putc1(p)     ((void)(p))
+
+#define os_memcmp               memcmp
+#define os_memcpy               memcpy
+#define os_memmove              memmove
+#define os_memset               memset
+#define os_strcat               strcat
+#define os_strchr               strchr
+#define os_strcmp               strcmp
+#define os_strcpy               strcpy
+#define os_strlen               strlen
+#define os_strncmp              strncmp
+#define os_strncpy              strncpy
+#define os_strstr               strstr
+#define os_sprintf              sprintf
+#define os_str2macaddr          ets_str2macaddr
+
+int ets_str2macaddr(void *mac, void *str);
+
+/* Debug output goes to stderr; the PTY carries only UART0 */
+#define os_printf(...)          fprintf(stderr, __VA_ARGS__)
+
+void ets_timer_arm_new(ETSTimer *ptimer, uint32_t time, bool repeat_flag, bool ms_flag);
+void ets_timer_disarm(ETSTimer *ptimer);
+void ets_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg);
+
+#define os_timer_arm(a, b, c)   ets_timer_arm_new(a, b, c, 1)
+#define os_timer_disarm         ets_timer_disarm
+#define os_timer_setfn          ets_timer_setfn
+
+#endif /* _OSAPI_H_ */
@@ -0,0 +1,14 @@
+/*
+ * Host build: the singly-linked tail queue entry used by the SDK lists.
+ */
+#ifndef _SYS_QUEUE_H_
+#define _SYS_QUEUE_H_
+
+#define STAILQ_ENTRY(type)                          \
+struct {                                            \
+    struct type *stqe_next; /* next element */      \
+}
+
+#define STAILQ_NEXT(elm, field)     ((elm)->field.stqe_next)
+
+#endif /* _SYS_QUEUE_H_ */
@@ -0,0 +1,139 @@
+/*
+ * Host build: system and Wi-Fi API of the NONOS SDK.
+ *
+ * The system calls (tasks, restart) are in host/sdk_host.c. There is no
+ * radio: the station "joins" any network after a short delay and gets the
+ * loopback address, so the IP commands can reach local servers.
+ */
+#ifndef __USER_INTERFACE_H__
+#define __USER_INTERFACE_H__
+
+#include "os_type.h"
+#include "ip_addr.h"
+#include "queue.h"
+#include "spi_flash.h"
+
+#define UPGRADE_FW_BIN1         0x00
+#define UPGRADE_FW_BIN2         0x01
+
+void system_restart(void);
+void system_deep_sleep(uint32 time_in_us);
+uint8 system_upgrade_userbin_check(void);
+void system_upgrade_reboot(void);
+void system_reboot_from(uint32 addr);
+const char *system_get_sdk_version(void);
+uint32 system_get_free_heap_size(void);
+
+#define USER_TASK_PRIO_0        0
+#define USER_TASK_PRIO_1        1
+#define USER_TASK_PRIO_2        2
+#define USER_TASK_PRIO_MAX      3
+
+bool system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen);
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par);
+
+#define NULL_MODE       0x00
+#define STATION_MODE    0x01
+#define SOFTAP_MODE     0x02
+#define STATIONAP_MODE  0x03
+
+typedef enum _auth_mode {
+    AUTH_OPEN           = 0,
+    AUTH_WEP,
+    AUTH_WPA_PSK,
+    AUTH_WPA2_PSK,
+    AUTH_WPA_WPA2_PSK,
+    AUTH_MAX
+} AUTH_MODE;
+
+uint8 wifi_get_opmode(void);
+bool wifi_set_opmode(uint8 opmode);
+
+struct bss_info {
+    STAILQ_ENTRY(bss_info)     next;
+
+    uint8 bssid[6];
+    uint8 ssid[32];
+    uint8 channel;
+    sint8 rssi;
+    AUTH_MODE authmode;
+    uint8 is_hidden;
+};
+
+typedef void (* scan_done_cb_t)(void *arg, STATUS status);
+
+struct station_config {
+    uint8 ssid[32];
+    uint8 password[64];
+    uint8 bssid_set;
+    uint8 bssid[6];
+};
+
+bool wifi_station_get_config(struct station_config *config);
+bool wifi_station_set_config(struct station_config *config);
+
+bool wifi_station_connect(void);
+bool wifi_station_disconnect(void);
+
+struct scan_config {
+    uint8 *ssid;
+    uint8 *bssid;
+    uint8 channel;
+    uint8 show_hidden;
+};
+
+bool wifi_station_scan(struct scan_config *config, scan_done_cb_t cb);
+
+enum {
+    STATION_IDLE = 0,
+    STATION_CONNECTING,
+    STATION_WRONG_PASSWORD,
+    STATION_NO_AP_FOUND,
+    STATION_CONNECT_FAIL,
+    STATION_GOT_IP
+};
+
+uint8 wifi_station_get_connect_status(void);
+
+bool wifi_station_dhcpc_start(void);
+bool wifi_station_dhcpc_stop(void);
+
+struct softap_config {
+    uint8 ssid[32];
+    uint8 password[64];
+    uint8 ssid_len;
+    uint8 channel;
+    AUTH_MODE authmode;
+    uint8 ssid_hidden;
+    uint8 max_connection;
+    uint16 beacon_interval;
+};
+
+bool wifi_softap_get_config(struct softap_config *config);
+bool wifi_softap_set_config(struct softap_config *config);
+
+struct station_info {
+    STAILQ_ENTRY(station_info)     next;
+
+    uint8 bssid[6];
+    struct ip_addr ip;
+};
+
+struct station_info *wifi_softap_get_station_info(void);
+void wifi_softap_free_station_info(void);
+
+bool wifi_softap_dhcps_start(void);
+bool wifi_softap_dhcps_stop(void);
+
+#define STATION_IF      0x00
+#define SOFTAP_IF       0x01
+
+bool wifi_get_ip_info(uint8 if_index, struct ip_info *info);
+bool wifi_set_ip_info(uint8 if_index, struct ip_info *info);
+bool wifi_get_macaddr(uint8 if_index, uint8 *macaddr);
+bool wifi_set_macaddr(uint8 if_index, uint8 *macaddr);
+
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
+
+#endif /* __USER_INTERFACE_H__ */
@@ -0,0 +1,88 @@
+/*
+ * File	: main.c
+ * Host build of the AT firmware: runs user_init() and the SDK main loop
+ * with UART0 on a pseudo-terminal.
+ *
+ *   at_host [-p PTY] [-b BAUD] [-f FLASH] [-j JOIN_MS] [-m HEAP]
+ *
+ * Without -p a new PTY is created and its name printed on stderr. -b paces
+ * both directions of UART0 at BAUD, as the wire does. -f keeps the flash
+ * (saved AT+CIOBAUD settings and the like) in a file. Statistics are
+ * printed on exit.
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "osapi.h"
+#include "host.h"
+
+void user_init(void);
+
+static void
+host_exit(int sig)
+{
+  host_print_stats();
+  _exit(0);
+}
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-p PTY] [-b BAUD] [-f FLASH] [-j JOIN_MS] [-m HEAP]\n", prog);
+  exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+  int opt;
+
+  host_argv = argv;
+  /* -F FD: the PTY, handed over by system_restart() */
+  while ((opt = getopt(argc, argv, "p:b:f:j:m:F:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'p':
+      host_opt.pty_path = optarg;
+      break;
+    case 'b':
+      host_opt.baud = strtoul(optarg, NULL, 0);
+      break;
+    case 'f':
+      host_opt.flash_path = optarg;
+      break;
+    case 'j':
+      host_opt.join_ms = strtoul(optarg, NULL, 0);
+      break;
+    case 'm':
+      host_opt.heap_size = strtoul(optarg, NULL, 0);
+      break;
+    case 'F':
+      host_opt.uart_fd = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc)
+  {
+    usage(argv[0]);
+  }
+
+  signal(SIGINT, host_exit);
+  signal(SIGTERM, host_exit);
+  signal(SIGPIPE, SIG_IGN);
+
+  host_sdk_init();
+  if (uart_host_open() < 0)
+  {
+    return 1;
+  }
+  wifi_host_init();
+  user_init();
+  host_run();
+  return 1;
+}
@@ -0,0 +1,641 @@
+/*
+ * File	: sdk_host.c
+ * Host build of the AT firmware: tasks, timers, heap, flash and system
+ * calls of the NONOS SDK, and the main loop that runs them.
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osapi.h"
+#include "mem.h"
+#include "user_interface.h"
+#include "upgrade.h"
+#include "ip_addr.h"
+#include "host.h"
+
+#define HOST_FLASH_SIZE     (1024 * 1024)
+#define HOST_WATCH_MAX      16
+
+struct host_options host_opt = {
+  .baud = 0,
+  .join_ms = 1000,
+  .heap_size = 40 * 1024,
+  .uart_fd = -1,
+};
+
+char **host_argv;
+
+/* Task queues, one per priority as in the SDK; 2 runs first */
+static struct {
+  os_task_t task;
+  os_event_t *queue;
+  uint8 len;
+  uint8 head;
+  uint8 cnt;
+  uint32 runs;
+  uint32 dropped;       /* system_os_post() on a full queue */
+  uint32 max_us;        /* longest single run */
+  uint64_t total_us;
+} tasks[USER_TASK_PRIO_MAX];
+
+static ETSTimer *timer_list;
+static uint32 timer_runs;
+static uint32 timer_max_us;
+static uint32 io_runs;          /* socket and PTY callbacks */
+static uint32 io_max_us;
+
+static struct {
+  int fd;
+  short events;
+  host_fd_cb_t cb;
+  void *arg;
+} watches[HOST_WATCH_MAX];
+static int watch_cnt;
+
+/* os_malloc() accounting; every block carries its size in front */
+static struct {
+  size_t cur;
+  size_t peak;
+  uint32 allocs;
+  uint32 failed;
+} heap;
+
+static uint8 flash[HOST_FLASH_SIZE];
+
+static struct timespec start_ts;
+
+uint64_t
+host_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)(ts.tv_sec - start_ts.tv_sec) * 1000000
+         + ts.tv_nsec / 1000 - start_ts.tv_nsec / 1000;
+}
+
+uint32
+host_ms(void)
+{
+  return (uint32)(host_us() / 1000);
+}
+
+void
+ets_delay_us(uint32_t us)
+{
+  uint64_t end = host_us() + us;
+
+  /* a busy wait on the chip; the UART keeps moving meanwhile */
+  while (host_us() < end)
+  {
+    host_irq_check();
+  }
+}
+
+/******************************************************************************
+ * Tasks
+*******************************************************************************/
+
+bool
+system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen)
+{
+  if (prio >= USER_TASK_PRIO_MAX || qlen == 0)
+  {
+    return false;
+  }
+  tasks[prio].task = task;
+  tasks[prio].queue = queue;
+  tasks[prio].len = qlen;
+  tasks[prio].head = 0;
+  tasks[prio].cnt = 0;
+  return true;
+}
+
+bool
+system_os_post(uint8 prio, os_signal_t sig, os_param_t par)
+{
+  os_event_t *e;
+
+  if (prio >= USER_TASK_PRIO_MAX || tasks[prio].task == NULL)
+  {
+    return false;
+  }
+  if (tasks[prio].cnt == tasks[prio].len)
+  {
+    tasks[prio].dropped++;
+    return false;
+  }
+  e = &tasks[prio].queue[(tasks[prio].head + tasks[prio].cnt) % tasks[prio].len];
+  e->sig = sig;
+  e->par = par;
+  tasks[prio].cnt++;
+  return true;
+}
+
+static bool
+host_run_task(void)
+{
+  int prio;
+
+  for (prio = USER_TASK_PRIO_MAX - 1; prio >= 0; prio--)
+  {
+    if (tasks[prio].cnt > 0)
+    {
+      os_event_t e = tasks[prio].queue[tasks[prio].head];
+      uint64_t t0 = host_us();
+      uint32 us;
+
+      tasks[prio].head = (tasks[prio].head + 1) % tasks[prio].len;
+      tasks[prio].cnt--;
+      tasks[prio].task(&e);
+
+      us = (uint32)(host_us() - t0);
+      tasks[prio].runs++;
+      tasks[prio].total_us += us;
+      if (us > tasks[prio].max_us)
+      {
+        tasks[prio].max_us = us;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/******************************************************************************
+ * Timers: a list sorted by expiry, run from the main loop
+*******************************************************************************/
+
+void
+ets_timer_disarm(ETSTimer *ptimer)
+{
+  ETSTimer **pp;
+
+  for (pp = &timer_list; *pp != NULL; pp = &(*pp)->timer_next)
+  {
+    if (*pp == ptimer)
+    {
+      *pp = ptimer->timer_next;
+      break;
+    }
+  }
+  ptimer->timer_next = NULL;
+}
+
+void
+ets_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg)
+{
+  ets_timer_disarm(ptimer);
+  ptimer->timer_func = pfunction;
+  ptimer->timer_arg = parg;
+}
+
+static void
+host_timer_insert(ETSTimer *ptimer)
+{
+  ETSTimer **pp;
+
+  for (pp = &timer_list; *pp != NULL; pp = &(*pp)->timer_next)
+  {
+    if ((int32)(ptimer->timer_expire - (*pp)->timer_expire) < 0)
+    {
+      break;
+    }
+  }
+  ptimer->timer_next = *pp;
+  *pp = ptimer;
+}
+
+void
+ets_timer_arm_new(ETSTimer *ptimer, uint32_t time, bool repeat_flag, bool ms_flag)
+{
+  uint32 ms = ms_flag ? time : time / 1000;
+
+  ets_timer_disarm(ptimer);
+  ptimer->timer_expire = host_ms() + ms;
+  ptimer->timer_period = repeat_flag ? (ms ? ms : 1) : 0;
+  host_timer_insert(ptimer);
+}
+
+static bool
+host_run_timer(void)
+{
+  ETSTimer *t = timer_list;
+  uint64_t t0;
+  uint32 us;
+
+  if (t == NULL || (int32)(host_ms() - t->timer_expire) < 0)
+  {
+    return false;
+  }
+  timer_list = t->timer_next;
+  t->timer_next = NULL;
+  if (t->timer_period != 0)
+  {
+    t->timer_expire += t->timer_period;
+    host_timer_insert(t);
+  }
+  if (t->timer_func == NULL)
+  {
+    return true;        /* armed without os_timer_setfn(), as at_port.c does */
+  }
+
+  t0 = host_us();
+  t->timer_func(t->timer_arg);
+  us = (uint32)(host_us() - t0);
+  timer_runs++;
+  if (us > timer_max_us)
+  {
+    timer_max_us = us;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Main loop
+*******************************************************************************/
+
+void
+host_watch(int fd, short events, host_fd_cb_t cb, void *arg)
+{
+  int i;
+
+  for (i = 0; i < watch_cnt; i++)
+  {
+    if (watches[i].fd == fd)
+    {
+      break;
+    }
+  }
+  if (i == watch_cnt)
+  {
+    if (watch_cnt == HOST_WATCH_MAX)
+    {
+      fprintf(stderr, "at_host: too many descriptors\n");
+      abort();
+    }
+    watch_cnt++;
+  }
+  watches[i].fd = fd;
+  watches[i].events = events;
+  watches[i].cb = cb;
+  watches[i].arg = arg;
+}
+
+void
+host_unwatch(int fd)
+{
+  int i;
+
+  for (i = 0; i < watch_cnt; i++)
+  {
+    if (watches[i].fd == fd)
+    {
+      watches[i] = watches[--watch_cnt];
+      return;
+    }
+  }
+}
+
+void
+host_run(void)
+{
+  struct pollfd pfd[HOST_WATCH_MAX];
+  host_fd_cb_t cbs[HOST_WATCH_MAX];
+  void *args[HOST_WATCH_MAX];
+
+  while (1)
+  {
+    int i, n, timeout;
+
+    host_irq_check();
+    if (host_run_task() || host_run_timer())
+    {
+      continue;
+    }
+
+    uart_host_poll();
+    timeout = uart_host_timeout_ms();
+    if (timer_list != NULL)
+    {
+      int32 due = (int32)(timer_list->timer_expire - host_ms());
+
+      due = due < 0 ? 0 : due;
+      timeout = (timeout < 0 || due < timeout) ? due : timeout;
+    }
+    if (uart_host_irq_pending())
+    {
+      timeout = 0;
+    }
+
+    /* Callbacks may change the watch list; poll a snapshot */
+    n = watch_cnt;
+    for (i = 0; i < n; i++)
+    {
+      pfd[i].fd = watches[i].fd;
+      pfd[i].events = watches[i].events;
+      pfd[i].revents = 0;
+      cbs[i] = watches[i].cb;
+      args[i] = watches[i].arg;
+    }
+    if (poll(pfd, n, timeout) < 0 && errno != EINTR)
+    {
+      perror("poll");
+      return;
+    }
+    for (i = 0; i < n; i++)
+    {
+      if (pfd[i].revents != 0)
+      {
+        uint64_t t0 = host_us();
+        uint32 us;
+
+        cbs[i](pfd[i].fd, pfd[i].revents, args[i]);
+        us = (uint32)(host_us() - t0);
+        io_runs++;
+        if (us > io_max_us)
+        {
+          io_max_us = us;
+        }
+      }
+    }
+  }
+}
+
+void
+host_print_stats(void)
+{
+  int prio;
+
+  fprintf(stderr, "at_host: %.1f s\n", host_us() / 1e6);
+  uart_host_print_stats();
+  for (prio = USER_TASK_PRIO_MAX - 1; prio >= 0; prio--)
+  {
+    if (tasks[prio].task == NULL)
+    {
+      continue;
+    }
+    fprintf(stderr, "  task %d: %u runs, avg %u us, max %u us, %u posts dropped\n",
+            prio, tasks[prio].runs,
+            tasks[prio].runs ? (uint32)(tasks[prio].total_us / tasks[prio].runs) : 0,
+            tasks[prio].max_us, tasks[prio].dropped);
+  }
+  fprintf(stderr, "  timers: %u runs, max %u us\n", timer_runs, timer_max_us);
+  fprintf(stderr, "  I/O callbacks: %u runs, max %u us\n", io_runs, io_max_us);
+  fprintf(stderr, "  heap: %u bytes in use, peak %u of %u, %u allocs, %u failed\n",
+          (uint32)heap.cur, (uint32)heap.peak, host_opt.heap_size, heap.allocs, heap.failed);
+}
+
+/******************************************************************************
+ * Heap
+*******************************************************************************/
+
+void *
+host_malloc(size_t size, bool zero)
+{
+  size_t *p;
+
+  if (heap.cur + size > host_opt.heap_size)
+  {
+    heap.failed++;
+    return NULL;
+  }
+  p = zero ? calloc(1, sizeof(size_t) + size) : malloc(sizeof(size_t) + size);
+  if (p == NULL)
+  {
+    heap.failed++;
+    return NULL;
+  }
+  *p = size;
+  heap.cur += size;
+  heap.allocs++;
+  if (heap.cur > heap.peak)
+  {
+    heap.peak = heap.cur;
+  }
+  return p + 1;
+}
+
+void
+host_free(void *ptr)
+{
+  size_t *p = ptr;
+
+  if (p == NULL)
+  {
+    return;
+  }
+  p--;
+  heap.cur -= *p;
+  free(p);
+}
+
+uint32
+system_get_free_heap_size(void)
+{
+  return host_opt.heap_size - (uint32)heap.cur;
+}
+
+/******************************************************************************
+ * Flash: erased (0xff) at start, loaded from and saved to an image file
+*******************************************************************************/
+
+static void
+flash_load(void)
+{
+  int fd;
+
+  memset(flash, 0xff, sizeof(flash));
+  if (host_opt.flash_path == NULL)
+  {
+    return;
+  }
+  fd = open(host_opt.flash_path, O_RDONLY);
+  if (fd >= 0)
+  {
+    if (read(fd, flash, sizeof(flash)) < 0)
+    {
+      perror(host_opt.flash_path);
+    }
+    close(fd);
+  }
+}
+
+static void
+flash_save(void)
+{
+  int fd;
+
+  if (host_opt.flash_path == NULL)
+  {
+    return;
+  }
+  fd = open(host_opt.flash_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || write(fd, flash, sizeof(flash)) != sizeof(flash))
+  {
+    perror(host_opt.flash_path);
+  }
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+}
+
+SpiFlashOpResult
+spi_flash_erase_sector(uint16 sec)
+{
+  if ((uint32)(sec + 1) * SPI_FLASH_SEC_SIZE > HOST_FLASH_SIZE)
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  memset(&flash[sec * SPI_FLASH_SEC_SIZE], 0xff, SPI_FLASH_SEC_SIZE);
+  flash_save();
+  return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult
+spi_flash_write(uint32 des_addr, uint32 *src_addr, uint32 size)
+{
+  uint32 i;
+
+  if (des_addr + size > HOST_FLASH_SIZE)
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  /* NOR flash: writes only clear bits */
+  for (i = 0; i < size; i++)
+  {
+    flash[des_addr + i] &= ((uint8 *)src_addr)[i];
+  }
+  flash_save();
+  return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult
+spi_flash_read(uint32 src_addr, uint32 *des_addr, uint32 size)
+{
+  if (src_addr + size > HOST_FLASH_SIZE)
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  memcpy(des_addr, &flash[src_addr], size);
+  return SPI_FLASH_RESULT_OK;
+}
+
+/******************************************************************************
+ * System
+*******************************************************************************/
+
+void
+host_sdk_init(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &start_ts);
+  flash_load();
+}
+
+/* A reset starts the program over; the PTY stays open across exec() */
+void
+system_restart(void)
+{
+  char fd_arg[16];
+  char *argv[8];
+  int i = 0;
+
+  host_print_stats();
+  uart_host_flush();
+  snprintf(fd_arg, sizeof(fd_arg), "%d", host_opt.uart_fd);
+  argv[i++] = host_argv[0];
+  argv[i++] = "-F";
+  argv[i++] = fd_arg;
+  for (char **a = host_argv + 1; *a != NULL && i < 7; a++)
+  {
+    /* drop -F/-p of the first start; the PTY is inherited now */
+    if (strcmp(*a, "-F") == 0 || strcmp(*a, "-p") == 0)
+    {
+      a++;
+      if (*a == NULL)
+      {
+        break;
+      }
+      continue;
+    }
+    argv[i++] = *a;
+  }
+  argv[i] = NULL;
+  fcntl(host_opt.uart_fd, F_SETFD, 0);
+  execv("/proc/self/exe", argv);
+  perror("execv");
+  exit(1);
+}
+
+void
+system_deep_sleep(uint32 time_in_us)
+{
+  usleep(time_in_us);
+  system_restart();
+}
+
+void
+system_reboot_from(uint32 addr)
+{
+  system_restart();
+}
+
+void
+system_upgrade_reboot(void)
+{
+  system_restart();
+}
+
+uint8
+system_upgrade_userbin_check(void)
+{
+  return UPGRADE_FW_BIN1;
+}
+
+bool
+system_upgrade_start(struct upgrade_server_info *server)
+{
+  return false;
+}
+
+const char *
+system_get_sdk_version(void)
+{
+  return "host";
+}
+
+uint32
+ipaddr_addr(const char *cp)
+{
+  struct in_addr a;
+
+  if (inet_aton(cp, &a) == 0)
+  {
+    return IPADDR_NONE;
+  }
+  return a.s_addr;
+}
+
+int
+ets_str2macaddr(void *mac, void *str)
+{
+  unsigned int b[6];
+  int i;
+
+  if (sscanf(str, "%2x:%2x:%2x:%2x:%2x:%2x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6)
+  {
+    return 0;
+  }
+  for (i = 0; i < 6; i++)
+  {
+    ((uint8 *)mac)[i] = b[i];
+  }
+  return 1;
+}
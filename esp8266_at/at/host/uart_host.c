@@ -0,0 +1,509 @@
+/*
+ * File	: uart_host.c
+ * Host build of the AT firmware: UART0/UART1 register model on a PTY.
+ *
+ * driver/uart.c and at_port.c access the UART through READ_PERI_REG and
+ * WRITE_PERI_REG, which end up here. UART0 has the 128-byte RX and TX
+ * FIFOs of the chip. Bytes from the PTY wait on the "wire" and land in the
+ * RX FIFO: at line rate if a baud rate is set, or as fast as there is room
+ * otherwise. Bytes written to the TX FIFO leave for the PTY the same way.
+ * With a baud rate set, RX bytes that find the FIFO full are lost and
+ * counted, as on the chip. UART1 (debug) goes to stderr.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ets_sys.h"
+#include "driver/uart.h"
+#include "driver/uart_register.h"
+#include "host.h"
+
+#define UART_FIFO_SIZE    128
+#define UART_WIRE_SIZE    4096
+#define UART_TXQ_SIZE     65536
+
+/* Lives in ROM on the chip, with these reset values */
+UartDevice UartDev = {
+  .baut_rate = BIT_RATE_115200,
+  .data_bits = EIGHT_BITS,
+  .exist_parity = STICK_PARITY_DIS,
+  .parity = NONE_BITS,
+  .stop_bits = ONE_STOP_BIT,
+  .flow_ctrl = NONE_CTRL,
+  .rcv_buff.RcvBuffSize = RX_BUFF_SIZE,
+};
+
+static struct {
+  int fd;
+  int slave_fd;                     /* kept open so an idle PTY does not hang up */
+  uint8 rx_fifo[UART_FIFO_SIZE];
+  uint16 rx_head;
+  uint16 rx_cnt;
+  uint8 wire[UART_WIRE_SIZE];       /* received from the PTY, not in the FIFO yet */
+  uint16 wire_head;
+  uint16 wire_cnt;
+  uint8 txq[UART_TXQ_SIZE];         /* written by the firmware, not on the PTY yet */
+  uint32 txq_head;
+  uint32 txq_cnt;
+  uint32 tx_unsent;                 /* tail of txq still in the TX FIFO */
+  uint64_t rx_next_us;
+  uint64_t tx_next_us;
+  uint32 int_latched;               /* TOUT, OVF: set by events, cleared by INT_CLR */
+  uint32 int_ena;
+  uint32 conf0;
+  uint32 conf1;
+  uint32 clkdiv;
+  /* counters for host_print_stats() */
+  uint32 rx_bytes;
+  uint32 tx_bytes;
+  uint32 rx_overflows;
+  uint32 tx_dropped;
+} u0;
+
+static int_handler_t uart_isr;
+static void *uart_isr_arg;
+static bool uart_isr_masked = true;
+static int intr_lock;
+static bool uart_in_isr;
+static uint32 uart_irqs;
+
+static uint32
+uart_byte_us(void)
+{
+  return host_opt.baud ? 10000000 / host_opt.baud : 0;
+}
+
+/* Move wire bytes into the RX FIFO and TX FIFO bytes onto the PTY queue */
+static void
+uart_advance(void)
+{
+  uint64_t now = host_us();
+  uint32 byte_us = uart_byte_us();
+
+  while (u0.wire_cnt > 0)
+  {
+    uint8 c;
+
+    if (byte_us == 0)
+    {
+      if (u0.rx_cnt == UART_FIFO_SIZE)
+      {
+        break;      /* unpaced: the wire simply waits */
+      }
+    }
+    else if (now < u0.rx_next_us)
+    {
+      break;
+    }
+    c = u0.wire[u0.wire_head];
+    u0.wire_head = (u0.wire_head + 1) % UART_WIRE_SIZE;
+    u0.wire_cnt--;
+    u0.rx_next_us += byte_us;
+    if (u0.rx_cnt == UART_FIFO_SIZE)
+    {
+      u0.rx_overflows++;
+      u0.int_latched |= UART_RXFIFO_OVF_INT_RAW;
+      continue;
+    }
+    u0.rx_fifo[(u0.rx_head + u0.rx_cnt) % UART_FIFO_SIZE] = c;
+    u0.rx_cnt++;
+    u0.rx_bytes++;
+  }
+  /* Line idle with data in the FIFO: the RX timeout fires */
+  if (u0.wire_cnt == 0 && u0.rx_cnt > 0 && (u0.conf1 & UART_RX_TOUT_EN))
+  {
+    u0.int_latched |= UART_RXFIFO_TOUT_INT_RAW;
+  }
+
+  if (byte_us == 0)
+  {
+    u0.tx_unsent = 0;
+  }
+  else
+  {
+    while (u0.tx_unsent > 0 && now >= u0.tx_next_us)
+    {
+      u0.tx_unsent--;
+      u0.tx_next_us += byte_us;
+    }
+  }
+}
+
+static void
+uart_flush_txq(void)
+{
+  while (u0.txq_cnt > u0.tx_unsent)
+  {
+    uint32 n = u0.txq_cnt - u0.tx_unsent;
+    ssize_t w;
+
+    if (n > UART_TXQ_SIZE - u0.txq_head)
+    {
+      n = UART_TXQ_SIZE - u0.txq_head;
+    }
+    w = write(u0.fd, &u0.txq[u0.txq_head], n);
+    if (w <= 0)
+    {
+      return;       /* PTY full: POLLOUT resumes */
+    }
+    u0.txq_head = (u0.txq_head + w) % UART_TXQ_SIZE;
+    u0.txq_cnt -= w;
+  }
+}
+
+static uint32
+uart_int_raw(void)
+{
+  uint32 raw = u0.int_latched;
+  uint32 full_thrhd = (u0.conf1 >> UART_RXFIFO_FULL_THRHD_S) & UART_RXFIFO_FULL_THRHD;
+  uint32 empty_thrhd = (u0.conf1 >> UART_TXFIFO_EMPTY_THRHD_S) & UART_TXFIFO_EMPTY_THRHD;
+
+  if (u0.rx_cnt > 0 && u0.rx_cnt >= full_thrhd)
+  {
+    raw |= UART_RXFIFO_FULL_INT_RAW;
+  }
+  if (u0.tx_unsent <= empty_thrhd)
+  {
+    raw |= UART_TXFIFO_EMPTY_INT_RAW;
+  }
+  return raw;
+}
+
+static void
+uart_tx_byte(uint8 c)
+{
+  uint32 byte_us = uart_byte_us();
+
+  if (u0.txq_cnt == UART_TXQ_SIZE)
+  {
+    u0.tx_dropped++;        /* nobody reads the PTY */
+    return;
+  }
+  if (byte_us != 0 && u0.tx_unsent == 0)
+  {
+    u0.tx_next_us = host_us() + byte_us;
+  }
+  u0.txq[(u0.txq_head + u0.txq_cnt) % UART_TXQ_SIZE] = c;
+  u0.txq_cnt++;
+  u0.tx_unsent += (byte_us != 0);
+  u0.tx_bytes++;
+}
+
+uint32
+host_reg_read(uint32 addr)
+{
+  uint32 val = 0;
+
+  uart_advance();
+
+  if (addr == UART_FIFO(UART0))
+  {
+    if (u0.rx_cnt > 0)
+    {
+      val = u0.rx_fifo[u0.rx_head];
+      u0.rx_head = (u0.rx_head + 1) % UART_FIFO_SIZE;
+      u0.rx_cnt--;
+      if (u0.rx_cnt == 0)
+      {
+        u0.int_latched &= ~UART_RXFIFO_TOUT_INT_RAW;
+      }
+    }
+  }
+  else if (addr == UART_INT_RAW(UART0))
+  {
+    val = uart_int_raw();
+  }
+  else if (addr == UART_INT_ST(UART0))
+  {
+    val = uart_int_raw() & u0.int_ena;
+  }
+  else if (addr == UART_INT_ENA(UART0))
+  {
+    val = u0.int_ena;
+  }
+  else if (addr == UART_STATUS(UART0))
+  {
+    val = ((u0.rx_cnt & UART_RXFIFO_CNT) << UART_RXFIFO_CNT_S)
+          | ((u0.tx_unsent & UART_TXFIFO_CNT) << UART_TXFIFO_CNT_S);
+    /* A busy-wait on the TX FIFO is where the chip would take the IRQ */
+    host_irq_check();
+  }
+  else if (addr == UART_CONF0(UART0))
+  {
+    val = u0.conf0;
+  }
+  else if (addr == UART_CONF1(UART0))
+  {
+    val = u0.conf1;
+  }
+  else if (addr == UART_CLKDIV(UART0))
+  {
+    val = u0.clkdiv;
+  }
+  /* UART1 is never short of TX space; anything else reads as 0 */
+  return val;
+}
+
+void
+host_reg_write(uint32 addr, uint32 val)
+{
+  uart_advance();
+
+  if (addr == UART_FIFO(UART0))
+  {
+    uart_tx_byte(val & 0xff);
+  }
+  else if (addr == UART_FIFO(UART1))
+  {
+    fputc(val & 0xff, stderr);
+  }
+  else if (addr == UART_INT_CLR(UART0))
+  {
+    u0.int_latched &= ~val;
+  }
+  else if (addr == UART_INT_ENA(UART0))
+  {
+    u0.int_ena = val;
+  }
+  else if (addr == UART_CONF0(UART0))
+  {
+    if (val & UART_RXFIFO_RST)
+    {
+      u0.rx_cnt = 0;
+    }
+    u0.conf0 = val & ~(UART_RXFIFO_RST | UART_TXFIFO_RST);
+  }
+  else if (addr == UART_CONF1(UART0))
+  {
+    u0.conf1 = val;
+  }
+  else if (addr == UART_CLKDIV(UART0))
+  {
+    u0.clkdiv = val & UART_CLKDIV_CNT;
+  }
+  /* watchdog feed (0x60000914) and the rest: nothing to do */
+}
+
+void
+uart_div_modify(uint8 uart_no, uint32 DivLatchValue)
+{
+  WRITE_PERI_REG(UART_CLKDIV(uart_no), DivLatchValue);
+}
+
+/* ROM putc on UART0, used directly by at_port.c for the echo */
+STATUS
+uart_tx_one_char(uint8 TxChar)
+{
+  while (((READ_PERI_REG(UART_STATUS(UART0)) >> UART_TXFIFO_CNT_S) & UART_TXFIFO_CNT) >= 126)
+  {
+  }
+  WRITE_PERI_REG(UART_FIFO(UART0), TxChar);
+  return OK;
+}
+
+void
+ets_isr_attach(int i, int_handler_t func, void *arg)
+{
+  if (i == ETS_UART_INUM)
+  {
+    uart_isr = func;
+    uart_isr_arg = arg;
+  }
+}
+
+void
+ets_isr_mask(unsigned intr)
+{
+  if (intr & (1 << ETS_UART_INUM))
+  {
+    uart_isr_masked = true;
+  }
+}
+
+void
+ets_isr_unmask(unsigned intr)
+{
+  if (intr & (1 << ETS_UART_INUM))
+  {
+    uart_isr_masked = false;
+  }
+}
+
+void
+ets_intr_lock(void)
+{
+  intr_lock++;
+}
+
+void
+ets_intr_unlock(void)
+{
+  intr_lock--;
+}
+
+bool
+uart_host_irq_pending(void)
+{
+  return uart_isr != NULL && !uart_isr_masked && intr_lock == 0
+         && (uart_int_raw() & u0.int_ena) != 0;
+}
+
+/* Level-triggered: the handler runs again while its cause is still there */
+void
+host_irq_check(void)
+{
+  int loops = 0;
+
+  if (uart_in_isr)
+  {
+    return;
+  }
+  uart_in_isr = true;
+  while (uart_host_irq_pending() && loops++ < 16)
+  {
+    uart_irqs++;
+    uart_isr(uart_isr_arg);
+    uart_advance();
+  }
+  uart_in_isr = false;
+}
+
+static void
+uart_host_io(int fd, short revents, void *arg)
+{
+  if (revents & POLLIN)
+  {
+    uint8 buf[512];
+    uint32 room = UART_WIRE_SIZE - u0.wire_cnt;
+    ssize_t n = read(fd, buf, room < sizeof(buf) ? room : sizeof(buf));
+    ssize_t i;
+
+    if (n <= 0 && !(n < 0 && errno == EAGAIN))
+    {
+      fprintf(stderr, "at_host: UART peer went away\n");
+      host_print_stats();
+      exit(0);
+    }
+    if (n > 0 && u0.wire_cnt == 0)
+    {
+      u0.rx_next_us = host_us() + uart_byte_us();
+    }
+    for (i = 0; i < n; i++)
+    {
+      u0.wire[(u0.wire_head + u0.wire_cnt) % UART_WIRE_SIZE] = buf[i];
+      u0.wire_cnt++;
+    }
+  }
+  else if (revents & (POLLHUP | POLLERR))
+  {
+    fprintf(stderr, "at_host: UART peer went away\n");
+    host_print_stats();
+    exit(0);
+  }
+  if (revents & POLLOUT)
+  {
+    uart_flush_txq();
+  }
+}
+
+/* Called by the main loop before it waits */
+void
+uart_host_poll(void)
+{
+  short events = 0;
+
+  uart_advance();
+  uart_flush_txq();
+  if (u0.wire_cnt < UART_WIRE_SIZE)
+  {
+    events |= POLLIN;
+  }
+  if (u0.txq_cnt > u0.tx_unsent)
+  {
+    events |= POLLOUT;
+  }
+  host_watch(u0.fd, events, uart_host_io, NULL);
+}
+
+/* How long the main loop may sleep before the line needs attention */
+int
+uart_host_timeout_ms(void)
+{
+  uint32 byte_us = uart_byte_us();
+
+  if (byte_us == 0)
+  {
+    return -1;
+  }
+  if ((u0.wire_cnt > 0 && u0.rx_cnt < UART_FIFO_SIZE) || u0.tx_unsent > 0)
+  {
+    return 1;
+  }
+  return -1;
+}
+
+void
+uart_host_flush(void)
+{
+  int fl = fcntl(u0.fd, F_GETFL);
+
+  fcntl(u0.fd, F_SETFL, fl & ~O_NONBLOCK);
+  u0.tx_unsent = 0;
+  uart_flush_txq();
+  fcntl(u0.fd, F_SETFL, fl);
+}
+
+int
+uart_host_open(void)
+{
+  struct termios tio;
+  char name[64];
+
+  if (host_opt.uart_fd >= 0)
+  {
+    u0.fd = host_opt.uart_fd;       /* back from system_restart() */
+  }
+  else if (host_opt.pty_path != NULL)
+  {
+    u0.fd = open(host_opt.pty_path, O_RDWR | O_NOCTTY);
+    if (u0.fd < 0)
+    {
+      perror(host_opt.pty_path);
+      return -1;
+    }
+    fprintf(stderr, "at_host: UART0 on %s\n", host_opt.pty_path);
+  }
+  else
+  {
+    if (openpty(&u0.fd, &u0.slave_fd, name, NULL, NULL) != 0)
+    {
+      perror("openpty");
+      return -1;
+    }
+    tcgetattr(u0.slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(u0.slave_fd, TCSANOW, &tio);
+    fprintf(stderr, "at_host: UART0 on %s\n", name);
+  }
+  if (tcgetattr(u0.fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tcsetattr(u0.fd, TCSANOW, &tio);
+  }
+  fcntl(u0.fd, F_SETFL, fcntl(u0.fd, F_GETFL) | O_NONBLOCK);
+  host_opt.uart_fd = u0.fd;
+  return 0;
+}
+
+void
+uart_host_print_stats(void)
+{
+  fprintf(stderr, "  uart0: rx %u bytes, tx %u bytes, %u RX FIFO overflows, %u TX dropped, %u IRQs\n",
+          u0.rx_bytes, u0.tx_bytes, u0.rx_overflows, u0.tx_dropped, uart_irqs);
+}
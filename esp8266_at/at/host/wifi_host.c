@@ -0,0 +1,235 @@
+/*
+ * File	: wifi_host.c
+ * Host build of the AT firmware: Wi-Fi API of the NONOS SDK without a radio.
+ *
+ * The station reaches STATION_GOT_IP host_opt.join_ms after
+ * wifi_station_connect() and gets 127.0.0.1, whatever the SSID. A scan
+ * always finds one access point, named after the configured SSID.
+ */
+#include <arpa/inet.h>
+
+#include "osapi.h"
+#include "user_interface.h"
+#include "host.h"
+
+static uint8 opmode = STATION_MODE;
+static uint8 station_status = STATION_IDLE;
+static struct station_config station_conf;
+static struct softap_config softap_conf = {
+  .ssid = "ESP_HOST",
+  .ssid_len = 8,
+  .channel = 1,
+  .authmode = AUTH_OPEN,
+  .max_connection = 4,
+  .beacon_interval = 100,
+};
+static struct ip_info ip[2];
+static uint8 mac[2][6] = {
+  { 0x18, 0xfe, 0x34, 0x00, 0x00, 0x01 },
+  { 0x1a, 0xfe, 0x34, 0x00, 0x00, 0x01 },
+};
+
+static os_timer_t join_timer;
+static os_timer_t scan_timer;
+static scan_done_cb_t scan_cb;
+static struct bss_info scan_list[2];
+
+static void
+wifi_host_joined(void *arg)
+{
+  station_status = STATION_GOT_IP;
+  ip[STATION_IF].ip.addr = inet_addr("127.0.0.1");
+  ip[STATION_IF].netmask.addr = inet_addr("255.0.0.0");
+  ip[STATION_IF].gw.addr = inet_addr("127.0.0.1");
+}
+
+static void
+wifi_host_scan_done(void *arg)
+{
+  struct bss_info *ap = &scan_list[1];
+
+  /* The SDK hands over a list whose first element is a dummy */
+  os_memset(scan_list, 0, sizeof(scan_list));
+  scan_list[0].next.stqe_next = ap;
+  os_strncpy((char *)ap->ssid, station_conf.ssid[0] ? (char *)station_conf.ssid : "host",
+             sizeof(ap->ssid));
+  os_memcpy(ap->bssid, mac[SOFTAP_IF], sizeof(ap->bssid));
+  ap->channel = 6;
+  ap->rssi = -40;
+  ap->authmode = AUTH_WPA2_PSK;
+  scan_cb(scan_list, OK);
+}
+
+void
+wifi_host_init(void)
+{
+  os_timer_setfn(&join_timer, wifi_host_joined, NULL);
+  os_timer_setfn(&scan_timer, wifi_host_scan_done, NULL);
+  ip[SOFTAP_IF].ip.addr = inet_addr("192.168.4.1");
+  ip[SOFTAP_IF].netmask.addr = inet_addr("255.255.255.0");
+  ip[SOFTAP_IF].gw.addr = inet_addr("192.168.4.1");
+}
+
+uint8
+wifi_get_opmode(void)
+{
+  return opmode;
+}
+
+bool
+wifi_set_opmode(uint8 mode)
+{
+  if (mode < STATION_MODE || mode > STATIONAP_MODE)
+  {
+    return false;
+  }
+  opmode = mode;
+  return true;
+}
+
+bool
+wifi_station_get_config(struct station_config *config)
+{
+  *config = station_conf;
+  return true;
+}
+
+bool
+wifi_station_set_config(struct station_config *config)
+{
+  station_conf = *config;
+  return true;
+}
+
+bool
+wifi_station_connect(void)
+{
+  if (!(opmode & STATION_MODE))
+  {
+    return false;
+  }
+  station_status = STATION_CONNECTING;
+  os_timer_arm(&join_timer, host_opt.join_ms, 0);
+  return true;
+}
+
+bool
+wifi_station_disconnect(void)
+{
+  os_timer_disarm(&join_timer);
+  station_status = STATION_IDLE;
+  ip[STATION_IF].ip.addr = 0;
+  return true;
+}
+
+uint8
+wifi_station_get_connect_status(void)
+{
+  return station_status;
+}
+
+bool
+wifi_station_scan(struct scan_config *config, scan_done_cb_t cb)
+{
+  if (!(opmode & STATION_MODE) || cb == NULL)
+  {
+    return false;
+  }
+  scan_cb = cb;
+  os_timer_arm(&scan_timer, 100, 0);
+  return true;
+}
+
+bool
+wifi_station_dhcpc_start(void)
+{
+  return true;
+}
+
+bool
+wifi_station_dhcpc_stop(void)
+{
+  return true;
+}
+
+bool
+wifi_softap_get_config(struct softap_config *config)
+{
+  *config = softap_conf;
+  return true;
+}
+
+bool
+wifi_softap_set_config(struct softap_config *config)
+{
+  softap_conf = *config;
+  return true;
+}
+
+/* Nobody joins the host's soft-AP */
+struct station_info *
+wifi_softap_get_station_info(void)
+{
+  return NULL;
+}
+
+void
+wifi_softap_free_station_info(void)
+{
+}
+
+bool
+wifi_softap_dhcps_start(void)
+{
+  return true;
+}
+
+bool
+wifi_softap_dhcps_stop(void)
+{
+  return true;
+}
+
+bool
+wifi_get_ip_info(uint8 if_index, struct ip_info *info)
+{
+  if (if_index > SOFTAP_IF)
+  {
+    return false;
+  }
+  *info = ip[if_index];
+  return true;
+}
+
+bool
+wifi_set_ip_info(uint8 if_index, struct ip_info *info)
+{
+  if (if_index > SOFTAP_IF)
+  {
+    return false;
+  }
+  ip[if_index] = *info;
+  return true;
+}
+
+bool
+wifi_get_macaddr(uint8 if_index, uint8 *macaddr)
+{
+  if (if_index > SOFTAP_IF)
+  {
+    return false;
+  }
+  os_memcpy(macaddr, mac[if_index], 6);
+  return true;
+}
+
+bool
+wifi_set_macaddr(uint8 if_index, uint8 *macaddr)
+{
+  if (if_index > SOFTAP_IF)
+  {
+    return false;
+  }
+  os_memcpy(mac[if_index], macaddr, 6);
+  return true;
+}
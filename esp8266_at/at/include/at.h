@@ -71,5 +71,6 @@ typedef struct
 
 void at_init(void);
 void at_cmdProcess(uint8_t *pAtRcvData);
+int16_t at_cmdParse(uint8_t *pCmd, int8_t *pCmdLen);
 
 #endif
@@ -24,6 +24,23 @@
 
 #define RX_BUFF_SIZE    256
 #define TX_BUFF_SIZE    100
+
+/* UART0 TX: responses wait in a RAM ring (a power of two, room for a whole
+ * +IPD segment) and the TXFIFO_EMPTY interrupt moves them to the 128-byte
+ * FIFO whenever it drains to UART_TX_EMPTY_THRHD bytes.
+ */
+#define UART_TX_RING_SIZE       2048
+#define UART_TX_EMPTY_THRHD     0x10
+
+/* UART0 RX: the interrupt empties the FIFO into a RAM ring (a power of
+ * two) as soon as it holds 0x10 bytes or the line goes idle; at_recvTask
+ * works through the ring from task context. Nothing holds the sender back:
+ * the ESP-01 does not bring out RTS (GPIO15) and the host runs without
+ * flow control. Bytes that arrive while the ring is full are dropped and
+ * counted (UartStats.rxDropped, the second field of AT+UARTSTAT?).
+ */
+#define UART_RX_RING_SIZE       1024
+
 #define UART0   0
 #define UART1   1
 
@@ -114,6 +131,22 @@ typedef struct {
 
 void uart_init(UartBautRate uart0_br, UartBautRate uart1_br);
 void uart0_sendStr(const char *str);
+void uart0_tx_buffer(uint8 *buf, uint16 len);
+uint16 uart0_tx_enqueue(const uint8 *buf, uint16 len);
+uint16 uart0_tx_room(void);
+void uart0_tx_flush(void);
+uint32 uart0_tx_stalls(void);
+uint16 uart0_rx_peek(uint8 **ppData);
+void uart0_rx_consume(uint16 len);
+
+typedef struct {
+    uint32 fifoOverflows;   /* times the 128-byte hardware FIFO overflowed */
+    uint32 rxDropped;       /* bytes dropped because the RX ring was full */
+    uint16 ringPeak;        /* highest RX ring fill level */
+    uint32 txStalls;        /* see uart0_tx_stalls() */
+} UartStats;
+
+void uart0_get_stats(UartStats *stats);
 
 #endif
 
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Generate the perfect hash table that at_cmdProcess() dispatches with.
+
+Reads the at_fun[] initializer in user/at_cmd.h and searches for a
+multiplier under which every command name lands in its own slot of a
+power-of-two table. The hash is the one at_cmdParse() computes while it
+scans the name, h = (h ^ c) * mult over 32 bits, and the slot is the top
+bits of h. Entries inside #ifdef blocks move the indexes of the entries
+after them, so a table is emitted for each combination of those macros.
+"""
+
+import argparse
+import itertools
+import re
+
+ENTRY = re.compile(r'^\s*\{\s*"([^"]*)"\s*,\s*(\d+)\s*,')
+NULL_ENTRY = re.compile(r'^\s*\{\s*NULL\s*,')
+
+
+def parse(path):
+    """Return [(name, len, macro or None)] in at_fun[] order, and the macros."""
+    entries = []
+    macros = []
+    cond = None
+    in_table = False
+    with open(path) as f:
+        for line in f:
+            if not in_table:
+                in_table = "at_fun[" in line
+                continue
+            if line.startswith("};"):
+                break
+            m = re.match(r"\s*#ifdef\s+(\w+)", line)
+            if m:
+                cond = m.group(1)
+                if cond not in macros:
+                    macros.append(cond)
+                continue
+            if re.match(r"\s*#endif", line):
+                cond = None
+                continue
+            if NULL_ENTRY.match(line):
+                entries.append((None, 0, cond))
+                continue
+            m = ENTRY.match(line)
+            if m:
+                name, length = m.group(1), int(m.group(2))
+                if len(name) != length:
+                    raise SystemExit("%s: at_cmdLen of \"%s\" is %d" % (path, name, length))
+                entries.append((name, length, cond))
+    return entries, macros
+
+
+def hash_name(name, mult):
+    h = 0
+    for c in name.encode():
+        h = ((h ^ c) * mult) & 0xFFFFFFFF
+    return h
+
+
+def find_mult(names, bits):
+    shift = 32 - bits
+    # Odd multipliers from the golden ratio on; the first few thousand do
+    for mult in range(0x9E3779B1, 0x9E3779B1 + 2 * 200000, 2):
+        slots = set()
+        for name in names:
+            slot = hash_name(name, mult) >> shift
+            if slot in slots:
+                break
+            slots.add(slot)
+        else:
+            return mult
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bits", type=int, default=6,
+                        help="log2 of the table size (default: 6)")
+    parser.add_argument("input", help="user/at_cmd.h")
+    parser.add_argument("-o", "--output", required=True)
+    args = parser.parse_args()
+
+    entries, macros = parse(args.input)
+    names = [e[0] for e in entries if e[0] is not None]
+    if len(names) >= (1 << args.bits):
+        parser.error("%d commands do not fit %d slots" % (len(names), 1 << args.bits))
+
+    # One multiplier for all configurations, so only the slot contents vary
+    mult = find_mult(names, args.bits)
+    if mult is None:
+        parser.error("no perfect hash with %d bits; raise --bits" % args.bits)
+    shift = 32 - args.bits
+
+    configs = []
+    for defined in itertools.product([False, True], repeat=len(macros)):
+        on = {m for m, d in zip(macros, defined) if d}
+        table = [0] * (1 << args.bits)
+        index = 0
+        for name, _, cond in entries:
+            if cond is not None and cond not in on:
+                continue
+            if name is not None:
+                table[hash_name(name, mult) >> shift] = index
+            index += 1
+        configs.append((on, table))
+
+    def rows(values):
+        return ",\n".join("  " + ", ".join("%2d" % v for v in values[i:i + 16])
+                          for i in range(0, len(values), 16))
+
+    with open(args.output, "w") as f:
+        f.write("/*\n")
+        f.write(" * File\t: at_cmd_hash.h\n")
+        f.write(" * Generated by tools/gen_at_cmd_hash.py from at_cmd.h, do not edit.\n")
+        f.write(" */\n")
+        f.write("#ifndef __AT_CMD_HASH_H\n#define __AT_CMD_HASH_H\n\n")
+        f.write("#define at_cmdHashMult    0x%08Xu\n" % mult)
+        f.write("#define at_cmdHashShift   %d\n" % shift)
+        f.write("#define at_cmdNameMax     %d\n\n" % max(len(n) for n in names))
+        f.write("/* at_fun[] index of the command in each slot; 0 if none */\n")
+        for i, (on, table) in enumerate(configs):
+            if macros:
+                test = " && ".join(("defined(%s)" if m in on else "!defined(%s)") % m
+                                   for m in macros)
+                if i == 0:
+                    f.write("#if %s\n" % test)
+                elif i == len(configs) - 1:
+                    f.write("#else\n")
+                else:
+                    f.write("#elif %s\n" % test)
+            f.write("static const uint8_t at_cmdHash[%d] = {\n%s\n};\n"
+                    % (1 << args.bits, rows(table)))
+        if macros:
+            f.write("#endif\n")
+        f.write("\n#endif\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -22,13 +22,14 @@
 #include "at_baseCmd.h"
 #include "user_interface.h"
 #include "at_version.h"
-#include "driver/uart_register.h"
+#include "driver/uart.h"
 
 /** @defgroup AT_BASECMD_Functions
   * @{
   */
 
 extern BOOL echoFlag;
+extern at_funcationType at_fun[];
 
 typedef struct
 {
@@ -82,6 +83,7 @@ void ICACHE_FLASH_ATTR
 at_exeCmdRst(uint8_t id)
 {
   at_backOk;
+  uart0_tx_flush();
   system_restart();
 }
 
@@ -131,6 +133,7 @@ at_exeCmdUpdate(uint8_t id)
 //  os_printf("%X\r\n",upFlag.reserve[0]);
 //  os_printf("%X\r\n",upFlag.reserve[1]);
 //  os_printf("%X\r\n",upFlag.reserve[2]);
+  uart0_tx_flush();
   os_delay_us(10000);
   system_reboot_from(0x00);
 }
@@ -238,14 +241,7 @@ at_setupCmdIpr(uint8_t id, char *pPara)
     at_backError;
     return;
   }
-  while(TRUE)
-  {
-    uint32_t fifo_cnt = READ_PERI_REG(UART_STATUS(0)) & (UART_TXFIFO_CNT<<UART_TXFIFO_CNT_S);
-    if((fifo_cnt >> UART_TXFIFO_CNT_S & UART_TXFIFO_CNT) == 0)
-    {
-      break;
-    }
-  }
+  uart0_tx_flush();
   os_delay_us(10000);
   uart_div_modify(0, UART_CLK_FREQ / tempUart.baud);
   tempUart.saved = 1;
@@ -262,6 +258,27 @@ at_setupCmdIpr(uint8_t id, char *pPara)
   at_backOk;
 }
 
+/**
+  * @brief  Query commad of uart counters.
+  *         FIFO overflows, RX bytes dropped on a full ring, RX ring peak,
+  *         TX ring stalls. Without flow control the first two are where
+  *         lost input shows up.
+  * @param  id: commad id number
+  * @retval None
+  */
+void ICACHE_FLASH_ATTR
+at_queryCmdUartstat(uint8_t id)
+{
+  char temp[64];
+  UartStats stats;
+
+  uart0_get_stats(&stats);
+  os_sprintf(temp, "%s:%d,%d,%d,%d\r\n", at_fun[id].at_cmdName,
+             stats.fifoOverflows, stats.rxDropped, stats.ringPeak, stats.txStalls);
+  uart0_sendStr(temp);
+  at_backOk;
+}
+
 void ICACHE_FLASH_ATTR
 at_setupCmdGslp(uint8_t id, char *pPara)
 {
@@ -270,6 +287,7 @@ at_setupCmdGslp(uint8_t id, char *pPara)
 	
 	n = atoi(pPara);
 	at_backOk;
+	uart0_tx_flush();
 	system_deep_sleep(n*1000);
 }
 /**
@@ -26,6 +26,7 @@ void at_exeCmdGmr(uint8_t id);
 void at_exeCmdUpdate(uint8_t id);
 #endif
 void at_setupCmdIpr(uint8_t id, char *pPara);
+void at_queryCmdUartstat(uint8_t id);
 #ifdef ali
 void at_setupCmdMpinfo(uint8_t id, char *pPara);
 #endif
@@ -16,6 +16,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "at_cmd.h"
+#include "at_cmd_hash.h"
 #include "user_interface.h"
 #include "osapi.h"
 //#include<stdlib.h>
@@ -25,64 +26,44 @@
   */ 
 
 /**
-  * @brief  Query and localization one commad.
-  * @param  cmdLen: received length of command
-  * @param  pCmd: point to received command 
+  * @brief  Scan the command name and look it up in one pass.
+  *         The name ends at '\r', '=', '?' or a digit. It is hashed while
+  *         scanned; the perfect hash in at_cmd_hash.h (generated from
+  *         at_fun[]) leaves one candidate, checked with a single compare.
+  * @param  pCmd: point to received command
+  * @param  pCmdLen: return the length of the command name
   * @retval the id of command
   *   @arg -1: failure
   */
-static int16_t ICACHE_FLASH_ATTR
-at_cmdSearch(int8_t cmdLen, uint8_t *pCmd)
+int16_t ICACHE_FLASH_ATTR
+at_cmdParse(uint8_t *pCmd, int8_t *pCmdLen)
 {
-  int16_t i;
+  uint32_t h;
+  uint8_t n, id;
 
-  if(cmdLen == 0)
+  h = 0;
+  for(n=0; n<=at_cmdNameMax; n++)
   {
-    return 0;
-  }
-  else if(cmdLen > 0)
-  {
-    for(i=1; i<at_cmdNum; i++)
+    if((pCmd[n] == '\r') || (pCmd[n] == '=') || (pCmd[n] == '?') || ((pCmd[n] >= '0')&&(pCmd[n] <= '9')))
     {
-//      os_printf("%d len %d\r\n", cmdLen, at_fun[i].at_cmdLen);
-      if(cmdLen == at_fun[i].at_cmdLen)
-      {
-//        os_printf("%s cmp %s\r\n", pCmd, at_fun[i].at_cmdName);
-        if(os_memcmp(pCmd, at_fun[i].at_cmdName, cmdLen) == 0) //think add cmp len first
-        {
-          return i;
-        }
-      }
+      break;
     }
+    h = (h ^ pCmd[n]) * at_cmdHashMult;
+  }
+  if(n > at_cmdNameMax)
+  {
+    return -1;
+  }
+  *pCmdLen = n;
+  if(n == 0)
+  {
+    return 0;
   }
-  return -1;
-}
-
-/**
-  * @brief  Get the length of commad.
-  * @param  pCmd: point to received command 
-  * @retval the length of command
-  *   @arg -1: failure
-  */
-static int8_t ICACHE_FLASH_ATTR
-at_getCmdLen(uint8_t *pCmd)
-{
-  uint8_t n,i;
-
-  n = 0;
-  i = 128;
 
-  while(i--)
+  id = at_cmdHash[h >> at_cmdHashShift];
+  if((id != 0) && (at_fun[id].at_cmdLen == n) && (os_memcmp(pCmd, at_fun[id].at_cmdName, n) == 0))
   {
-    if((*pCmd == '\r') || (*pCmd == '=') || (*pCmd == '?') || ((*pCmd >= '0')&&(*pCmd <= '9')))
-    {
-      return n;
-    }
-    else
-    {
-      pCmd++;
-      n++;
-    }
+    return id;
   }
   return -1;
 }
@@ -101,15 +82,7 @@ at_cmdProcess(uint8_t *pAtRcvData)
   int8_t cmdLen;
   uint16_t i;
 
-  cmdLen = at_getCmdLen(pAtRcvData);
-  if(cmdLen != -1)
-  {
-    cmdId = at_cmdSearch(cmdLen, pAtRcvData);
-  }
-  else 
-  {
-  	cmdId = -1;
-  }
+  cmdId = at_cmdParse(pAtRcvData, &cmdLen);
   if(cmdId != -1)
   {
 //    os_printf("cmd id: %d\r\n", cmdId);
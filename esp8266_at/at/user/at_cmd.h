@@ -25,6 +25,9 @@
 
 #define at_cmdNum   32
 
+/* at_cmd_hash.h is generated from this table: run
+ * tools/gen_at_cmd_hash.py after changing it (the host build does).
+ */
 at_funcationType at_fun[at_cmdNum]={
   {NULL, 0, NULL, NULL, NULL, at_exeCmdNull},
   {"E", 1, NULL, NULL, at_setupCmdE, NULL},
@@ -32,6 +35,7 @@ at_funcationType at_fun[at_cmdNum]={
   {"+GMR", 4, NULL, NULL, NULL, at_exeCmdGmr},
   {"+GSLP", 5, NULL, NULL, at_setupCmdGslp, NULL},
   {"+IPR", 4, NULL, NULL, at_setupCmdIpr, NULL},
+  {"+UARTSTAT", 9, NULL, at_queryCmdUartstat, NULL, NULL},
 #ifdef ali
   {"+UPDATE", 7, NULL, NULL, NULL, at_exeCmdUpdate},
 #endif
@@ -0,0 +1,29 @@
+/*
+ * File	: at_cmd_hash.h
+ * Generated by tools/gen_at_cmd_hash.py from at_cmd.h, do not edit.
+ */
+#ifndef __AT_CMD_HASH_H
+#define __AT_CMD_HASH_H
+
+#define at_cmdHashMult    0x9E37A2F7u
+#define at_cmdHashShift   26
+#define at_cmdNameMax     10
+
+/* at_fun[] index of the command in each slot; 0 if none */
+#if !defined(ali)
+static const uint8_t at_cmdHash[64] = {
+   0,  0, 22,  0,  6, 13,  0,  0,  0,  0,  0,  0, 16, 25, 17,  0,
+  23, 11,  3,  0,  0,  0, 19, 27, 20,  0,  0,  0,  0,  0, 24,  0,
+   2, 29,  0, 10,  0,  7,  0,  0, 18,  1, 12,  0,  8,  0,  4,  9,
+   0,  0,  0,  0, 28, 14,  0,  0,  5,  0, 15,  0, 26,  0, 21,  0
+};
+#else
+static const uint8_t at_cmdHash[64] = {
+   0,  0, 23, 31,  6, 14,  7,  0,  0,  0,  0,  0, 17, 26, 18,  0,
+  24, 12,  3,  0,  0,  0, 20, 28, 21,  0,  0,  0,  0,  0, 25,  0,
+   2, 30,  0, 11,  0,  8,  0,  0, 19,  1, 13,  0,  9,  0,  4, 10,
+   0,  0,  0,  0, 29, 15,  0,  0,  5,  0, 16,  0, 27,  0, 22,  0
+};
+#endif
+
+#endif
@@ -343,6 +343,19 @@ at_udpclient_recv(void *arg, char *pdata, unsigned short len)
   at_backOk;
 }
 
+/**
+  * @brief  A transparent send is over, sent or lost with its link.
+  *         at_recvTask takes up the data it left in the uart RX ring.
+  * @param  None
+  * @retval None
+  */
+static void ICACHE_FLASH_ATTR
+at_ipDataSendDone(void)
+{
+  ipDataSendFlag = 0;
+  system_os_post(at_recvTaskPrio, 0, 0);
+}
+
 /**
   * @brief  Client send over callback function.
   * @param  arg: contain the ip link information
@@ -355,11 +368,9 @@ at_tcpclient_sent_cb(void *arg)
 //  os_printf("send_cb\r\n");
   if(IPMODE == TRUE)
   {
-    ipDataSendFlag = 0;
   	os_timer_disarm(&at_delayCheck);
   	os_timer_arm(&at_delayCheck, 20, 0);
-  	system_os_post(at_recvTaskPrio, 0, 0); ////
-    ETS_UART_INTR_ENABLE();
+    at_ipDataSendDone();
     return;
   }
   specialAtState = TRUE;
@@ -454,7 +465,7 @@ at_tcpclient_recon_cb(void *arg, sint8 errType)
   if(at_state == at_statIpTraning)
   {
   	linkTemp->repeaTime++;
-    ETS_UART_INTR_ENABLE(); ///
+    at_ipDataSendDone();
     os_printf("Traning recon\r\n");
     if(linkTemp->repeaTime > 10)
     {
@@ -529,7 +540,6 @@ at_tcpclient_recon_cb(void *arg, sint8 errType)
         //    at_state = at_statIdle;
         //    return;
       }
-      ETS_UART_INTR_ENABLE(); ///
       specialAtState = true;
       at_state = at_statIdle;
       return;
@@ -853,7 +863,7 @@ at_tcpclient_discon_cb(void *arg)
   }
   if(at_state == at_statIpTraning)
   {
-    ETS_UART_INTR_ENABLE(); ///
+    at_ipDataSendDone();
     os_printf("Traning nodiscon\r\n");
     pespconn->proto.tcp->local_port = espconn_port();
     espconn_connect(pespconn);
@@ -941,7 +951,6 @@ at_tcpclient_discon_cb(void *arg)
       }
     }
   }
-  ETS_UART_INTR_ENABLE(); 
 //  IPMODE = FALSE;
   specialAtState = TRUE;
   at_state = at_statIdle;
@@ -1329,7 +1338,7 @@ at_ipDataTransparent(void *arg)
 	}
 	else if(at_tranLen)
 	{
-	  ETS_UART_INTR_DISABLE(); //
+	  /* at_recvTask leaves the uart data in the RX ring until the sent callback */
     espconn_sent(pLink[0].pCon, at_dataLine, at_tranLen); //UartDev.rcv_buff.pRcvMsgBuff ////
     ipDataSendFlag = 1;
 //    pDataLine = UartDev.rcv_buff.pRcvMsgBuff;
@@ -1381,6 +1390,7 @@ at_exeCmdCipsend(uint8_t id)
   }
 	pDataLine = at_dataLine;//UartDev.rcv_buff.pRcvMsgBuff;
 	at_tranLen = 0;
+  ipDataSendFlag = 0; /* a send lost with the last session must not hold this one */
   specialAtState = FALSE;
   at_state = at_statIpTraning;
   os_timer_disarm(&at_delayCheck);
@@ -1498,7 +1508,6 @@ at_tcpserver_discon_cb(void *arg)
 //    uart0_sendStr("Unlink\r\n");
     disAllFlag = false;
   }
-  ETS_UART_INTR_ENABLE();
   specialAtState = true;
   at_state = at_statIdle;
 }
@@ -1551,7 +1560,6 @@ at_tcpserver_recon_cb(void *arg, sint8 errType)
 //    at_state = at_statIdle;
     at_backOk;
   }
-  ETS_UART_INTR_ENABLE();
   specialAtState = true;
   at_state = at_statIdle;
 }
@@ -1924,6 +1932,7 @@ at_upDate_rsp(void *arg)
     os_printf("device_upgrade_success\r\n");
 //    action = "device_upgrade_success";
     at_backOk;
+    uart0_tx_flush();
     system_upgrade_reboot();
 //    os_sprintf(pbuf, UPGRADE_FRAME,
 //               devkey, action,
@@ -72,9 +72,33 @@ static void at_procTask(os_event_t *events);
 //static void at_busyTask(os_event_t *events);
 static void at_recvTask(os_event_t *events);
 
+/**
+  * @brief  Echo received bytes back, except line feeds.
+  * @param  pData: received bytes
+  * @param  len: number of bytes
+  * @retval None
+  */
+static void ICACHE_FLASH_ATTR
+at_echo(uint8_t *pData, uint16_t len)
+{
+  uint16_t i;
+
+  if(!echoFlag)
+  {
+    return;
+  }
+  for(i = 0; i < len; i++)
+  {
+    if(pData[i] != '\n')
+    {
+      uart0_tx_buffer(&pData[i], 1); //display back
+    }
+  }
+}
+
 /**
   * @brief  Uart receive task.
-  * @param  events: contain the uart receive data
+  * @param  events: no used, the data waits in the uart RX ring
   * @retval None
   */
 static void ICACHE_FLASH_ATTR ///////
@@ -82,171 +106,136 @@ at_recvTask(os_event_t *events)
 {
   static uint8_t atHead[2];
   static uint8_t *pCmdLine;
+  uint8_t *pData;
+  uint16_t len;
+  uint16_t i;
+  uint16_t n;
   uint8_t temp;
 
-//  temp = events->par;
-//  temp = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
-//  temp = 'X';
+  /* A transparent send still owns at_dataLine: the data stays in the ring
+   * and at_tcpclient_sent_cb() posts this task again */
+  if((at_state == at_statIpTraning) && ipDataSendFlag)
+  {
+    return;
+  }
+
   //add transparent determine
-  while(READ_PERI_REG(UART_STATUS(UART0)) & (UART_RXFIFO_CNT << UART_RXFIFO_CNT_S))
+  while((len = uart0_rx_peek(&pData)) > 0)
   {
-//    temp = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
     WRITE_PERI_REG(0X60000914, 0x73); //WTD
 
-    if(at_state != at_statIpTraning)
-    {
-      temp = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
-      if((temp != '\n') && (echoFlag))
-      {
-        uart_tx_one_char(temp); //display back
-//        uart_tx_one_char(UART0, temp);
-      }
-    }
-//    if((at_state != at_statIpTraning) && (temp != '\n') && (echoFlag))
-//    {
-//      uart_tx_one_char(temp); //display back
-//    }
-
-    switch(at_state)
+    /* Data states take the whole span at once */
+    if(at_state == at_statIpTraning)
     {
-    case at_statIdle: //serch "AT" head
-      atHead[0] = atHead[1];
-      atHead[1] = temp;
-      if((os_memcmp(atHead, "AT", 2) == 0) || (os_memcmp(atHead, "at", 2) == 0))
+      os_timer_disarm(&at_delayCheck);
+      n = &at_dataLine[at_dataLenMax] - pDataLine;
+      if(n == 0)
       {
-        at_state = at_statRecving;
-        pCmdLine = at_cmdLine;
-        atHead[1] = 0x00;
+        os_timer_arm(&at_delayCheck, 0, 0);
+        os_printf("exceed\r\n");
+        return;
       }
-      else if(temp == '\n') //only get enter
+      if(len < n)
       {
-        uart0_sendStr("\r\nERROR\r\n");
+        n = len;
       }
-      break;
-
-    case at_statRecving: //push receive data to cmd line
-      *pCmdLine = temp;
-      if(temp == '\n')
+      os_memcpy(pDataLine, pData, n);
+      pDataLine += n;
+      at_tranLen += n;
+      uart0_rx_consume(n);
+      if(pDataLine == &at_dataLine[at_dataLenMax])
       {
-        system_os_post(at_procTaskPrio, 0, 0);
-        pCmdLine++;
-        *pCmdLine = '\0';
-        at_state = at_statProcess;
-        if(echoFlag)
-        {
-          uart0_sendStr("\r\n"); ///////////
-        }
-      }
-      else if(pCmdLine >= &at_cmdLine[at_cmdLenMax - 1])
-      {
-        at_state = at_statIdle;
+        os_timer_arm(&at_delayCheck, 0, 0);
+        return;
       }
-      pCmdLine++;
-      break;
-
-    case at_statProcess: //process data
-      if(temp == '\n')
+      os_timer_arm(&at_delayCheck, 20, 0);
+      continue;
+    }
+    if(at_state == at_statIpSending)
+    {
+      n = ((at_sendLen < at_dataLenMax) ? at_sendLen : at_dataLenMax) - (pDataLine - at_dataLine);
+      if(len < n)
       {
-//      system_os_post(at_busyTaskPrio, 0, 1);
-        uart0_sendStr("\r\nbusy p...\r\n");
+        n = len;
       }
-      break;
-
-    case at_statIpSending:
-      *pDataLine = temp;
-      if((pDataLine >= &at_dataLine[at_sendLen - 1]) || (pDataLine >= &at_dataLine[at_dataLenMax - 1]))
+      at_echo(pData, n);
+      os_memcpy(pDataLine, pData, n);
+      pDataLine += n;
+      uart0_rx_consume(n);
+      if((pDataLine >= &at_dataLine[at_sendLen]) || (pDataLine >= &at_dataLine[at_dataLenMax]))
       {
         system_os_post(at_procTaskPrio, 0, 0);
         at_state = at_statIpSended;
       }
-      else
-      {
-        pDataLine++;
-      }
-//    *pDataLine = temp;
-//    if (pDataLine == &UartDev.rcv_buff.pRcvMsgBuff[at_sendLen-1])
-//    {
-//      system_os_post(at_procTaskPrio, 0, 0);
-//      at_state = at_statIpSended;
-//    }
-//    pDataLine++;
-      break;
+      continue;
+    }
 
-    case at_statIpSended: //send data
-      if(temp == '\n')
+    /* Command states go byte by byte, the state may change on any of them */
+    for(i = 0; (i < len) && (at_state != at_statIpTraning) && (at_state != at_statIpSending); i++)
+    {
+      temp = pData[i];
+      if((temp != '\n') && (echoFlag))
       {
-//      system_os_post(at_busyTaskPrio, 0, 2);
-        uart0_sendStr("busy s...\r\n");
+        uart0_tx_buffer(&temp, 1); //display back
       }
-      break;
 
-    case at_statIpTraning:
-      os_timer_disarm(&at_delayCheck);
-//      *pDataLine = temp;
-      if(pDataLine > &at_dataLine[at_dataLenMax - 1])
+      switch(at_state)
       {
-        os_timer_arm(&at_delayCheck, 0, 0);
-        os_printf("exceed\r\n");
-        return;
-      }
-      else if(pDataLine == &at_dataLine[at_dataLenMax - 1])
-      {
-        temp = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
-        *pDataLine = temp;
-        pDataLine++;
-        at_tranLen++;
-        os_timer_arm(&at_delayCheck, 0, 0);
-        return;
-      }
-      else
-      {
-        temp = READ_PERI_REG(UART_FIFO(UART0)) & 0xFF;
-        *pDataLine = temp;
-        pDataLine++;
-        at_tranLen++;
-//        if(ipDataSendFlag == 0)
-//        {
-//          os_timer_arm(&at_delayCheck, 20, 0);
-//        }
-        os_timer_arm(&at_delayCheck, 20, 0);
-      }
-      break;
+      case at_statIdle: //serch "AT" head
+        atHead[0] = atHead[1];
+        atHead[1] = temp;
+        if((os_memcmp(atHead, "AT", 2) == 0) || (os_memcmp(atHead, "at", 2) == 0))
+        {
+          at_state = at_statRecving;
+          pCmdLine = at_cmdLine;
+          atHead[1] = 0x00;
+        }
+        else if(temp == '\n') //only get enter
+        {
+          uart0_sendStr("\r\nERROR\r\n");
+        }
+        break;
 
-//      os_timer_disarm(&at_delayCheck);
-//      *pDataLine = temp;
-//      if(pDataLine >= &at_dataLine[at_dataLenMax - 1])
-//      {
-////        ETS_UART_INTR_DISABLE();
-////      pDataLine++;
-//        at_tranLen++;
-////      os_timer_arm(&at_delayCheck, 1, 0); /////
-//        system_os_post(at_procTaskPrio, 0, 0);
-//        break;
-//      }
-//      pDataLine++;
-//      at_tranLen++;
-//      if(ipDataSendFlag == 0)
-//      {
-//        os_timer_arm(&at_delayCheck, 20, 0);
-//      }
-//      break;
+      case at_statRecving: //push receive data to cmd line
+        *pCmdLine = temp;
+        if(temp == '\n')
+        {
+          system_os_post(at_procTaskPrio, 0, 0);
+          pCmdLine++;
+          *pCmdLine = '\0';
+          at_state = at_statProcess;
+          if(echoFlag)
+          {
+            uart0_sendStr("\r\n"); ///////////
+          }
+        }
+        else if(pCmdLine >= &at_cmdLine[at_cmdLenMax - 1])
+        {
+          at_state = at_statIdle;
+        }
+        pCmdLine++;
+        break;
 
-    default:
-      if(temp == '\n')
-      {
+      case at_statProcess: //process data
+        if(temp == '\n')
+        {
+          uart0_sendStr("\r\nbusy p...\r\n");
+        }
+        break;
+
+      case at_statIpSended: //send data
+        if(temp == '\n')
+        {
+          uart0_sendStr("busy s...\r\n");
+        }
+        break;
+
+      default:
+        break;
       }
-      break;
     }
+    uart0_rx_consume(i);
   }
-  if(UART_RXFIFO_FULL_INT_ST == (READ_PERI_REG(UART_INT_ST(UART0)) & UART_RXFIFO_FULL_INT_ST))
-  {
-    WRITE_PERI_REG(UART_INT_CLR(UART0), UART_RXFIFO_FULL_INT_CLR);
-  }
-  else if(UART_RXFIFO_TOUT_INT_ST == (READ_PERI_REG(UART_INT_ST(UART0)) & UART_RXFIFO_TOUT_INT_ST))
-  {
-    WRITE_PERI_REG(UART_INT_CLR(UART0), UART_RXFIFO_TOUT_INT_CLR);
-  }
-  ETS_UART_INTR_ENABLE();
 }
 
 /**
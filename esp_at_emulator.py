@@ -0,0 +1,627 @@
+"""ESP-01 stand-in for running the node without hardware.
+
+Speaks the AT dialect of esp8266_at/at (the at_fun[] table in
+user/at_cmd.h and the byte handling of user/at_port.c) on a PTY, and opens
+real TCP sockets for CIPSTART, so the Zephyr app built for native_sim can
+talk to python_handler.py on this machine:
+
+    west build -b native_sim zephyrproject/app
+    python3 python_handler.py 8080
+    python3 esp_at_emulator.py --exe build/zephyr/zephyr.exe \\
+        --server 127.0.0.1:8080 --duration 300 --json run.json
+
+--latency-ms/--jitter-ms add link latency, --baud paces the UART like the
+real 115200 8N1 line, and the --p-* options inject faults. Request counts,
+readings per second and request latency are printed every --stats-s and
+at the end.
+"""
+import argparse
+import json
+import os
+import queue
+import random
+import re
+import socket
+import subprocess
+import sys
+import threading
+import time
+import tty
+from urllib.parse import urlparse, parse_qs
+
+from python_handler import decode_batch
+
+AT_CMD_LEN_MAX = 128        # at_cmdLenMax in at_port.c
+AT_DATA_LEN_MAX = 2048      # at_dataLenMax, CIPSEND limit
+AT_LINK_MAX = 5             # at_linkMax in mux mode
+
+BACK_OK = b"\r\nOK\r\n"
+BACK_ERROR = b"\r\nERROR\r\n"
+
+# at_stateType in at.h
+ST_IDLE, ST_RECVING, ST_PROCESS, ST_IP_SENDING, ST_IP_SENDED = range(5)
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.start = time.monotonic()
+        self.counts = {k: 0 for k in (
+            "commands", "connects", "connect_fails", "requests", "send_fails",
+            "peer_closes", "readings", "summaries", "bytes_up", "bytes_down",
+            "stale_links", "busy", "corrupted")}
+        self.request_ms = []    # CIPSEND command -> first +IPD byte on the UART
+        self.server_ms = []     # request forwarded -> first response byte from the socket
+
+    def add(self, key, n=1):
+        with self.lock:
+            self.counts[key] += n
+
+    def sample(self, series, ms):
+        with self.lock:
+            getattr(self, series).append(ms)
+
+    def snapshot(self):
+        with self.lock:
+            elapsed = time.monotonic() - self.start
+            out = dict(self.counts)
+            out["elapsed_s"] = round(elapsed, 1)
+            out["readings_per_s"] = round(self.counts["readings"] / elapsed, 3) if elapsed else 0.0
+            out["requests_per_s"] = round(self.counts["requests"] / elapsed, 3) if elapsed else 0.0
+            for series in ("request_ms", "server_ms"):
+                v = getattr(self, series)
+                out[series] = {"n": len(v),
+                               "p50": round(percentile(v, 50), 1),
+                               "p95": round(percentile(v, 95), 1),
+                               "max": round(max(v), 1) if v else 0.0}
+            return out
+
+    def print(self):
+        s = self.snapshot()
+        r, sv = s["request_ms"], s["server_ms"]
+        print(f"[emu] {s['elapsed_s']:.0f}s: {s['requests']} requests ({s['requests_per_s']:.2f}/s), "
+              f"{s['readings']} readings ({s['readings_per_s']:.2f}/s), {s['summaries']} summaries, "
+              f"{s['connects']} connects, {s['send_fails']} send fails, {s['peer_closes']} peer closes, "
+              f"{s['stale_links']} stale links")
+        print(f"[emu]   request ms p50 {r['p50']} p95 {r['p95']} max {r['max']}, "
+              f"server ms p50 {sv['p50']} p95 {sv['p95']} max {sv['max']}")
+
+
+class Uart:
+    """One end of the PTY. Writes are queued and paced at 10 bits per byte."""
+
+    def __init__(self, fd, baud, stats, p_corrupt, rng):
+        self.fd = fd
+        self.byte_s = 10.0 / baud if baud else 0.0
+        self.stats = stats
+        self.p_corrupt = p_corrupt
+        self.rng = rng
+        self.txq = queue.Queue()
+        threading.Thread(target=self._tx, daemon=True).start()
+
+    def write(self, data, on_sent=None):
+        self.txq.put((bytes(data), on_sent))
+
+    def read(self):
+        data = os.read(self.fd, 256)
+        # the node cannot push bytes faster than the line carries them
+        if self.byte_s:
+            time.sleep(len(data) * self.byte_s)
+        return data
+
+    def _tx(self):
+        while True:
+            data, on_sent = self.txq.get()
+            if data and self.rng.random() < self.p_corrupt:
+                i = self.rng.randrange(len(data))
+                data = data[:i] + bytes([data[i] ^ 0x20]) + data[i + 1:]
+                self.stats.add("corrupted")
+            if self.byte_s:
+                time.sleep(len(data) * self.byte_s)
+            try:
+                os.write(self.fd, data)
+            except OSError:
+                return
+            if on_sent:
+                on_sent()
+
+
+class Link:
+    def __init__(self, link_id, sock):
+        self.id = link_id
+        self.sock = sock
+        self.peer = sock.getpeername()[:2]
+        self.closing = False        # CIPCLOSE from the node, not the peer
+        self.sent_at = None         # request forwarded, no response byte yet
+        self.cmd_at = None          # CIPSEND line of that request
+
+    def shutdown(self):
+        # wakes _link_rx, which reports CLOSED
+        try:
+            self.sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+
+class Esp:
+    def __init__(self, uart, args, stats, rng):
+        self.uart = uart
+        self.args = args
+        self.stats = stats
+        self.rng = rng
+        self.lock = threading.RLock()
+        self.jobs = queue.Queue()
+        self.state = ST_IDLE
+        self.echo = True
+        self.head = b"  "
+        self.line = bytearray()
+        self.data = bytearray()
+        self.send_len = 0
+        self.send_id = 0
+        self.send_cmd_at = None
+        self.mode = 1
+        self.joined = False
+        self.mux = False
+        self.links = {}
+        threading.Thread(target=self._proc, daemon=True).start()
+
+    def out(self, data, on_sent=None):
+        if isinstance(data, str):
+            data = data.encode()
+        self.uart.write(data, on_sent)
+
+    def delay(self):
+        ms = self.args.latency_ms + self.rng.uniform(0, self.args.jitter_ms)
+        if ms > 0:
+            time.sleep(ms / 1000.0)
+
+    def link_prefix(self, link):
+        return f"{link.id}," if self.mux else ""
+
+    # at_recvTask: one byte at a time, exactly like the firmware
+    def feed(self, data):
+        for c in data:
+            with self.lock:
+                self._feed_byte(c)
+
+    def _feed_byte(self, c):
+        if c != 0x0A and self.echo:
+            self.out(bytes([c]))
+
+        if self.state == ST_IDLE:
+            self.head = self.head[1:] + bytes([c])
+            if self.head in (b"AT", b"at"):
+                self.state = ST_RECVING
+                self.line = bytearray()
+                self.head = b"  "
+            elif c == 0x0A:
+                self.out(BACK_ERROR)
+        elif self.state == ST_RECVING:
+            self.line.append(c)
+            if c == 0x0A:
+                self.state = ST_PROCESS
+                if self.echo:
+                    self.out(b"\r\n")
+                self.jobs.put((self._command, bytes(self.line)))
+            elif len(self.line) >= AT_CMD_LEN_MAX - 1:
+                self.state = ST_IDLE
+        elif self.state == ST_PROCESS:
+            if c == 0x0A:
+                self.out(b"\r\nbusy p...\r\n")
+        elif self.state == ST_IP_SENDING:
+            self.data.append(c)
+            if len(self.data) >= self.send_len:
+                self.state = ST_IP_SENDED
+                self.jobs.put((self._send_data, bytes(self.data)))
+        elif self.state == ST_IP_SENDED:
+            if c == 0x0A:
+                self.out(b"busy s...\r\n")
+
+    # at_procTask: commands run one after the other off the receive path
+    def _proc(self):
+        while True:
+            fn, arg = self.jobs.get()
+            fn(arg)
+            with self.lock:
+                if self.state in (ST_PROCESS, ST_IP_SENDED):
+                    self.state = ST_IDLE
+
+    def _command(self, line):
+        self.stats.add("commands")
+        if self.rng.random() < self.args.p_busy:
+            # as if the line arrived while the previous command was still running
+            self.stats.add("busy")
+            self.out(b"\r\nbusy p...\r\n")
+            return
+        text = line.rstrip(b"\r\n").decode(errors="replace")
+        m = re.match(r"(\+[A-Z]+|E)?(.*)$", text)
+        name, rest = m.group(1) or "", m.group(2)
+        if name == "":
+            self.out(BACK_OK if rest == "" else BACK_ERROR)
+            return
+        handler = getattr(self, "cmd_" + name.lstrip("+").lower(), None)
+        if handler is None:
+            self.out(BACK_ERROR)
+            return
+        if rest == "":
+            kind, para = "exe", None
+        elif rest == "?":
+            kind, para = "query", None
+        elif rest == "=?":
+            kind, para = "test", None
+        elif rest[0] == "=" or rest[0].isdigit():
+            kind, para = "setup", rest.lstrip("=")
+        else:
+            self.out(BACK_ERROR)
+            return
+        handler(kind, para)
+
+    def cmd_e(self, kind, para):
+        if kind != "setup" or para not in ("0", "1"):
+            self.out(BACK_ERROR)
+            return
+        self.echo = para == "1"
+        self.out(BACK_OK)
+
+    def cmd_rst(self, kind, para):
+        self.out(BACK_OK)
+        with self.lock:
+            for link in self.links.values():
+                link.closing = True
+                link.shutdown()
+            self.links.clear()
+            self.joined = False
+            self.mux = False
+            self.echo = True
+        time.sleep(0.5)
+        self.out(b"\r\nready\r\n")
+
+    def cmd_gmr(self, kind, para):
+        self.out("0018000902-AI03\r\nesp_at_emulator\r\n")
+        self.out(BACK_OK)
+
+    def cmd_cwmode(self, kind, para):
+        if kind == "query":
+            self.out(f"+CWMODE:{self.mode}\r\n")
+        elif kind == "setup" and para in ("1", "2", "3"):
+            self.mode = int(para)
+        elif kind != "test":
+            self.out(BACK_ERROR)
+            return
+        self.out(BACK_OK)
+
+    def cmd_cwjap(self, kind, para):
+        if kind == "query":
+            self.out('+CWJAP:"emulator"\r\n' if self.joined else "No AP\r\n")
+            self.out(BACK_OK if self.joined else BACK_ERROR)
+            return
+        if kind != "setup" or self.mode == 2:
+            self.out(BACK_ERROR)
+            return
+        # at_japChack polls every 2 s; stay busy until "got IP"
+        time.sleep(self.args.join_ms / 1000.0)
+        self.joined = True
+        self.out(BACK_OK)
+
+    def cmd_cwqap(self, kind, para):
+        self.joined = False
+        self.out(BACK_OK)
+
+    def cmd_cifsr(self, kind, para):
+        if kind != "exe":
+            self.out(BACK_OK if kind == "test" else BACK_ERROR)
+            return
+        ip = "127.0.0.1" if self.joined else "0.0.0.0"
+        self.out(f'+CIFSR:STAIP,"{ip}"\r\n+CIFSR:STAMAC,"18:fe:34:00:00:01"\r\n')
+        self.out(BACK_OK)
+
+    def cmd_cipstatus(self, kind, para):
+        if kind == "exe":
+            state = 3 if self.links else (2 if self.joined else 5)
+            self.out(f"STATUS:{state}\r\n")
+            for link in self.links.values():
+                host, port = link.peer
+                self.out(f'+CIPSTATUS:{link.id},"TCP","{host}",{port},0\r\n')
+        self.out(BACK_OK)
+
+    def cmd_cipmux(self, kind, para):
+        if kind == "query":
+            self.out(f"+CIPMUX:{int(self.mux)}\r\n")
+            self.out(BACK_OK)
+            return
+        if kind != "setup":
+            self.out(BACK_ERROR)
+            return
+        if self.links:
+            self.out(b"link is builded\r\n")
+            return
+        if para not in ("0", "1"):
+            self.out(BACK_ERROR)
+            return
+        self.mux = para == "1"
+        self.out(BACK_OK)
+
+    def cmd_cipstart(self, kind, para):
+        if kind != "setup":
+            self.out(BACK_OK if kind == "test" else BACK_ERROR)
+            return
+        if self.mode == 1 and not self.joined:
+            self.out(b"no ip\r\n")
+            return
+        m = re.match(r'(?:(\d),)?"(TCP|UDP)","([^"]*)",(\d+)$', para)
+        if m is None or bool(m.group(1)) != self.mux:
+            self.out(b"ENTRY ERROR\r\n")
+            return
+        link_id = int(m.group(1) or 0)
+        if link_id >= AT_LINK_MAX:
+            self.out(b"ID ERROR\r\n")
+            return
+        if m.group(2) != "TCP":
+            self.out(b"Link typ ERROR\r\n")
+            return
+        if link_id in self.links:
+            self.out(b"ALREAY CONNECT\r\n")
+            return
+        host, port = m.group(3), int(m.group(4))
+        if self.args.server:
+            host, port = self.args.server
+        self.delay()
+        sock = None
+        if self.rng.random() >= self.args.p_connect_fail:
+            try:
+                sock = socket.create_connection((host, port), timeout=5)
+                sock.settimeout(None)
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            except OSError as e:
+                print(f"[emu] connect {host}:{port} failed: {e}")
+        if sock is None:
+            # at_tcpclient_recon_cb prints the id even in single-link mode
+            self.stats.add("connect_fails")
+            self.out(f"{link_id},CLOSED\r\n")
+            self.out(BACK_ERROR)
+            return
+        link = Link(link_id, sock)
+        with self.lock:
+            self.links[link_id] = link
+        self.stats.add("connects")
+        threading.Thread(target=self._link_rx, args=(link,), daemon=True).start()
+        self.out(f"{self.link_prefix(link)}CONNECT\r\n")
+        self.out(BACK_OK)
+
+    def cmd_cipsend(self, kind, para):
+        if kind != "setup":
+            self.out(BACK_OK if kind == "test" else BACK_ERROR)
+            return
+        if self.mux:
+            m = re.match(r"(\d),(\d+)$", para)
+            if m is None or int(m.group(1)) >= AT_LINK_MAX:
+                self.out(BACK_ERROR)
+                return
+            link_id, length = int(m.group(1)), m.group(2)
+        else:
+            link_id, length = 0, para
+        link = self.links.get(link_id)
+        if link is not None and self.rng.random() < self.args.p_stale:
+            # the link died without a CLOSED line (lost FIN, AP roam): the
+            # firmware only finds out here
+            with self.lock:
+                del self.links[link_id]
+            link.shutdown()
+            self.stats.add("stale_links")
+            link = None
+        if link is None:
+            self.out(b"link is not\r\n")
+            return
+        if not length.isdigit():
+            self.out(b"type error\r\n")
+            return
+        if int(length) > AT_DATA_LEN_MAX:
+            self.out(b"too long\r\n")
+            return
+        with self.lock:
+            self.send_id = link_id
+            self.send_len = int(length)
+            self.send_cmd_at = time.monotonic()
+            self.data = bytearray()
+            self.state = ST_IP_SENDING
+        self.out(b"> ")
+
+    def _send_data(self, data):
+        link = self.links.get(self.send_id)
+        if link is None:
+            self.out(b"link is not\r\n")
+            return
+        self.delay()
+        if self.rng.random() < self.args.p_send_fail:
+            self.stats.add("send_fails")
+            self.out(b"\r\nSEND FAIL\r\n")
+            return
+        try:
+            link.sock.sendall(data)
+        except OSError:
+            self.stats.add("send_fails")
+            self.out(b"\r\nSEND FAIL\r\n")
+            return
+        link.sent_at = time.monotonic()
+        link.cmd_at = self.send_cmd_at
+        self.stats.add("bytes_up", len(data))
+        self.count_request(data)
+        self.out(b"\r\nSEND OK\r\n")
+        if self.rng.random() < self.args.p_close:
+            # the server dropping the keep-alive connection under the node
+            threading.Timer(0.01, link.shutdown).start()
+
+    def cmd_cipclose(self, kind, para):
+        if kind == "test":
+            self.out(BACK_OK)
+            return
+        if kind == "exe" and self.mux:
+            self.out(b"MUX=1\r\n")
+            return
+        link_id = int(para) if kind == "setup" and para.isdigit() else 0
+        link = self.links.get(link_id)
+        if link is None or (kind == "setup" and not self.mux):
+            self.out(BACK_ERROR)
+            return
+        link.closing = True
+        link.shutdown()
+
+    def _link_rx(self, link):
+        while True:
+            try:
+                data = link.sock.recv(1460)
+            except OSError:
+                data = b""
+            if not data:
+                break
+            self.delay()
+            self.stats.add("bytes_down", len(data))
+            if link.sent_at is not None:
+                self.stats.sample("server_ms", (time.monotonic() - link.sent_at) * 1000)
+                cmd_at = link.cmd_at
+                link.sent_at = None
+                on_sent = lambda: self.stats.sample("request_ms", (time.monotonic() - cmd_at) * 1000)
+            else:
+                on_sent = None
+            # at_tcpclient_recv: header, payload, then OK
+            self.out(f"\r\n+IPD,{self.link_prefix(link)}{len(data)}:".encode() + data, on_sent)
+            self.out(BACK_OK)
+        link.sock.close()
+        with self.lock:
+            if self.links.get(link.id) is link:
+                del self.links[link.id]
+            else:
+                return      # dropped by AT+RST
+        if not link.closing:
+            self.stats.add("peer_closes")
+        self.out(f"{self.link_prefix(link)}CLOSED\r\n")
+        self.out(BACK_OK)
+
+    def count_request(self, data):
+        line = data.split(b"\r\n", 1)[0].decode(errors="replace").split(" ")
+        if len(line) < 2:
+            return
+        self.stats.add("requests")
+        url = urlparse(line[1])
+        query = parse_qs(url.query)
+        if url.path.endswith("/batch.php"):
+            if "z" in query:
+                self.stats.add("readings", len(decode_batch(query["z"][0])))
+            else:
+                self.stats.add("readings", len([e for e in query.get("d", [""])[0].split(",") if e]))
+        elif url.path.endswith("/summary.php"):
+            self.stats.add("summaries")
+        else:
+            self.stats.add("readings")
+
+
+def start_node(exe, exe_args):
+    # native_sim prints the PTY it gave uart_1 on startup
+    proc = subprocess.Popen([exe] + exe_args, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, text=True, bufsize=1)
+    found = queue.Queue()
+
+    def pump():
+        for line in proc.stdout:
+            m = re.search(r"uart_1 connected to pseudotty: (\S+)", line)
+            if m:
+                found.put(m.group(1))
+            print(f"[node] {line}", end="")
+
+    threading.Thread(target=pump, daemon=True).start()
+    try:
+        return proc, found.get(timeout=10)
+    except queue.Empty:
+        proc.kill()
+        sys.exit("zephyr.exe did not report a uart_1 PTY (is &uart1 enabled?)")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ESP8266 AT firmware emulator on a PTY")
+    src = ap.add_mutually_exclusive_group()
+    src.add_argument("--exe", help="run this native_sim zephyr.exe and attach to its uart_1")
+    src.add_argument("--pty", help="attach to an existing PTY (e.g. /dev/pts/5)")
+    ap.add_argument("--server", help="HOST:PORT to connect to instead of the CIPSTART target")
+    ap.add_argument("--baud", type=int, default=115200, help="UART pacing, 0 for none")
+    ap.add_argument("--latency-ms", type=float, default=0.0, help="one-way link latency")
+    ap.add_argument("--jitter-ms", type=float, default=0.0, help="uniform extra latency")
+    ap.add_argument("--join-ms", type=int, default=2000, help="time CWJAP takes to get an IP")
+    ap.add_argument("--p-connect-fail", type=float, default=0.0, help="CIPSTART fails")
+    ap.add_argument("--p-send-fail", type=float, default=0.0, help="SEND FAIL instead of SEND OK")
+    ap.add_argument("--p-close", type=float, default=0.0, help="peer closes after a request")
+    ap.add_argument("--p-stale", type=float, default=0.0,
+                    help="CIPSEND finds the link silently gone (\"link is not\")")
+    ap.add_argument("--p-busy", type=float, default=0.0, help="command answered with busy p...")
+    ap.add_argument("--p-corrupt", type=float, default=0.0, help="flip a bit in a UART write")
+    ap.add_argument("--seed", type=int, help="fault injection seed")
+    ap.add_argument("--duration", type=float, help="stop after this many seconds")
+    ap.add_argument("--stats-s", type=float, default=10.0, help="print stats this often")
+    ap.add_argument("--json", help="write the final stats here")
+    args, exe_args = ap.parse_known_args()
+    if args.server:
+        host, port = args.server.rsplit(":", 1)
+        args.server = (host, int(port))
+
+    proc = None
+    if args.exe:
+        proc, path = start_node(args.exe, exe_args)
+        fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    elif args.pty:
+        path = args.pty
+        fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    else:
+        fd, slave = os.openpty()
+        tty.setraw(slave)
+        path = os.ttyname(slave)
+    tty.setraw(fd)
+    print(f"[emu] ESP-01 on {path}, {args.baud or 'unpaced'} baud, "
+          f"latency {args.latency_ms}+{args.jitter_ms} ms")
+
+    rng = random.Random(args.seed)
+    stats = Stats()
+    uart = Uart(fd, args.baud, stats, args.p_corrupt, rng)
+    esp = Esp(uart, args, stats, rng)
+    uart.write(b"\r\nready\r\n")
+
+    def rx():
+        while True:
+            try:
+                data = uart.read()
+            except OSError:
+                return      # the node went away
+            if not data:
+                return
+            esp.feed(data)
+
+    rx_thread = threading.Thread(target=rx, daemon=True)
+    rx_thread.start()
+
+    end = time.monotonic() + args.duration if args.duration else None
+    next_stats = time.monotonic() + args.stats_s
+    try:
+        while rx_thread.is_alive() and (end is None or time.monotonic() < end):
+            time.sleep(0.2)
+            if time.monotonic() >= next_stats:
+                stats.print()
+                next_stats += args.stats_s
+    except KeyboardInterrupt:
+        pass
+
+    stats.print()
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(stats.snapshot(), f, indent=2)
+    if proc:
+        proc.terminate()
+        proc.wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,7 +1,55 @@
+import base64
+import sys
+import time
 from http.server import BaseHTTPRequestHandler, HTTPServer
 from urllib.parse import urlparse, parse_qs
 
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+
+def decode_batch(z):
+    # z = base64url(varint dseq, varint dts, varint zigzag(dvalue) per reading),
+    # deltas against the previous reading, the first one against zero
+    data = base64.urlsafe_b64decode(z + "=" * (-len(z) % 4))
+    seq = ts = value = 0
+    pos = 0
+    entries = []
+    while pos < len(data):
+        dseq, pos = read_varint(data, pos)
+        dts, pos = read_varint(data, pos)
+        dval, pos = read_varint(data, pos)
+        seq = (seq + dseq) & 0xFFFF
+        ts = (ts + dts) & 0xFFFFFFFF
+        value += (dval >> 1) ^ -(dval & 1)
+        entries.append((seq, ts, value))
+    return entries
+
+def parse_batch(query):
+    # z=<compact batch> or d=<seq>:<uptime_ms>:<value>,...  with now=<uptime_ms> at send time
+    now_ms = int(query["now"][0])
+    received = time.time()
+    if "z" in query:
+        entries = decode_batch(query["z"][0])
+    else:
+        entries = [tuple(int(x) for x in e.split(":"))
+                   for e in query.get("d", [""])[0].split(",") if e]
+    rows = []
+    for seq, ts_ms, value in entries:
+        age_s = ((now_ms - ts_ms) & 0xFFFFFFFF) / 1000.0
+        rows.append((seq, received - age_s, value))
+    return rows
+
 class SimpleGETHandler(BaseHTTPRequestHandler):
+    # HTTP/1.1 so the node's keep-alive connection is reused between readings
+    protocol_version = "HTTP/1.1"
+
     def do_GET(self):
         # Parse URL and query
         parsed_url = urlparse(self.path)
@@ -13,11 +61,28 @@ class SimpleGETHandler(BaseHTTPRequestHandler):
         print(f"Client IP: {self.client_address[0]}")
         print(f"Headers:\n{self.headers}")
 
-        # Respond to client
+        if parsed_url.path.endswith("/batch.php"):
+            sensor = query_components.get("sensor", ["?"])[0]
+            rows = parse_batch(query_components)
+            print(f"Batch of {len(rows)} {sensor} readings:")
+            for seq, ts, value in rows:
+                stamp = time.strftime("%H:%M:%S", time.localtime(ts))
+                print(f"  seq {seq:5d}  {stamp}  {value}")
+        elif parsed_url.path.endswith("/summary.php"):
+            q = {k: int(v[0]) for k, v in query_components.items() if k != "sensor" and v[0].lstrip("-").isdigit()}
+            age_s = ((q["now"] - q["t"]) & 0xFFFFFFFF) / 1000.0
+            stamp = time.strftime("%H:%M:%S", time.localtime(time.time() - age_s))
+            std = q["var"] ** 0.5
+            print(f"Window ending {stamp}: n={q['n']} min={q['min']} max={q['max']} "
+                  f"mean={q['mean']} std={std:.1f} p50={q['p50']} p95={q['p95']} p99={q['p99']}")
+
+        # Respond to client; Content-Length marks where the response ends
+        body = b"GET request received successfully!\n"
         self.send_response(200)
         self.send_header("Content-type", "text/plain")
+        self.send_header("Content-Length", str(len(body)))
         self.end_headers()
-        self.wfile.write(b"GET request received successfully!\n")
+        self.wfile.write(body)
 
     # Disable logging to console by BaseHTTPRequestHandler
     def log_message(self, format, *args):
@@ -31,4 +96,5 @@ def run_server(host="0.0.0.0", port=80):
     httpd.serve_forever()
 
 if __name__ == "__main__":
-    run_server()
+    # optional port, e.g. 8080 to match SERVER_PORT without root
+    run_server(port=int(sys.argv[1]) if len(sys.argv) > 1 else 80)
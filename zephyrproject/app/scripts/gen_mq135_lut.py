@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Generate the MQ-135 Rs/R0 -> ppm lookup table.
+
+The datasheet curve is ppm = a * (Rs/R0)^b. Evaluating it on the node means
+soft-float pow(); instead this tabulates it at geometrically spaced ratios,
+and the driver interpolates linearly between neighbouring points.
+"""
+
+import argparse
+import math
+
+RATIO_SHIFT = 10    # Rs/R0 in Q10
+PPM_SHIFT = 4       # ppm in Q4
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--a", type=float, default=116.6020682,
+                        help="curve coefficient (default: CO2)")
+    parser.add_argument("--b", type=float, default=-2.769034857,
+                        help="curve exponent (default: CO2)")
+    parser.add_argument("--min-ratio", type=float, default=0.25)
+    parser.add_argument("--max-ratio", type=float, default=4.0)
+    parser.add_argument("--points", type=int, default=65)
+    parser.add_argument("-o", "--output", required=True)
+    args = parser.parse_args()
+
+    step = (args.max_ratio / args.min_ratio) ** (1.0 / (args.points - 1))
+    ratios = []
+    ppms = []
+    for i in range(args.points):
+        r = args.min_ratio * step ** i
+        ratios.append(round(r * (1 << RATIO_SHIFT)))
+        ppms.append(round(args.a * math.pow(r, args.b) * (1 << PPM_SHIFT)))
+
+    if any(b <= a for a, b in zip(ratios, ratios[1:])):
+        parser.error("ratio points collapse in Q%d; use fewer points" % RATIO_SHIFT)
+    if max(ratios) > 0xFFFF or max(ppms) > 0xFFFFFFFF:
+        parser.error("table values overflow their types")
+
+    def rows(values):
+        return ",\n".join("    " + ", ".join(str(v) for v in values[i:i + 8])
+                          for i in range(0, len(values), 8))
+
+    with open(args.output, "w") as f:
+        f.write("/* Generated by scripts/gen_mq135_lut.py, do not edit.\n")
+        f.write(" * ppm = %.7g * (Rs/R0)^%.7g for Rs/R0 in [%g, %g]\n"
+                % (args.a, args.b, args.min_ratio, args.max_ratio))
+        f.write(" */\n\n")
+        f.write("#define MQ135_LUT_RATIO_SHIFT %d\n" % RATIO_SHIFT)
+        f.write("#define MQ135_LUT_PPM_SHIFT %d\n" % PPM_SHIFT)
+        f.write("#define MQ135_LUT_LEN %d\n\n" % args.points)
+        f.write("/* Rs/R0, ascending */\n")
+        f.write("static const uint16_t mq135_lut_ratio[MQ135_LUT_LEN] = {\n%s\n};\n\n"
+                % rows(ratios))
+        f.write("/* ppm at each ratio, descending */\n")
+        f.write("static const uint32_t mq135_lut_ppm[MQ135_LUT_LEN] = {\n%s\n};\n"
+                % rows(ppms))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "adc_filter.h"
+
+/* Insertion sort: a handful of compares for n <= 9, no recursion, no divides */
+static int16_t median(int16_t *v, size_t n)
+{
+    for (size_t i = 1; i < n; i++) {
+        int16_t x = v[i];
+        size_t j = i;
+
+        while (j > 0 && v[j - 1] > x) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = x;
+    }
+    return v[n / 2];
+}
+
+int32_t adc_filter_update(struct adc_filter *f, int16_t *burst, size_t n)
+{
+    int32_t x_q8 = (int32_t)median(burst, n) << 8;
+
+    if (!f->primed) {
+        /* start at the first reading instead of ramping up from zero */
+        f->ema_q8 = x_q8;
+        f->primed = true;
+    } else {
+        /* arithmetic shift keeps the sign of negative steps */
+        f->ema_q8 += (x_q8 - f->ema_q8) >> f->shift;
+    }
+
+    f->readings++;
+
+    return (f->ema_q8 + 128) >> 8;
+}
+
+int32_t adc_filter_update_block(struct adc_filter *f, const int16_t *samples, size_t n,
+                                size_t stride)
+{
+    int16_t burst[ADC_FILTER_BURST];
+    int32_t value = (f->ema_q8 + 128) >> 8;
+
+    for (size_t i = 0; i + ADC_FILTER_BURST <= n; i += ADC_FILTER_BURST) {
+        for (size_t j = 0; j < ADC_FILTER_BURST; j++, samples += stride) {
+            burst[j] = *samples;
+        }
+        value = adc_filter_update(f, burst, ADC_FILTER_BURST);
+    }
+    return value;
+}
+
+void adc_filter_print(const struct adc_filter *f, const char *name)
+{
+    printk("%s filter: %u readings\n", name, f->readings);
+}
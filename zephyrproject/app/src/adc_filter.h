@@ -0,0 +1,39 @@
+#ifndef ADC_FILTER_H_
+#define ADC_FILTER_H_
+
+#include <stddef.h>
+#include <zephyr/types.h>
+
+/* Conversions taken back-to-back per reading (one plus extra_samplings).
+ * Odd, so the median is a real sample; small, as the sort is O(n^2).
+ */
+#define ADC_FILTER_BURST 5
+
+/* Integer-only smoothing for one ADC channel: the median of each burst
+ * rejects single-conversion spikes, an EMA then smooths across readings.
+ */
+struct adc_filter {
+    uint8_t shift;          /* EMA weight of a new reading is 1/2^shift */
+    bool primed;
+    int32_t ema_q8;         /* filter state, Q24.8 */
+
+    uint32_t readings;
+};
+
+#define ADC_FILTER_INIT(ema_shift) { .shift = (ema_shift) }
+
+/* Feed one burst of n raw samples (reordered in place) and return the
+ * filtered value in ADC counts.
+ */
+int32_t adc_filter_update(struct adc_filter *f, int16_t *burst, size_t n);
+
+/* Feed n samples taken stride apart (one channel of an interleaved scan
+ * buffer, left untouched) as n / ADC_FILTER_BURST consecutive bursts and
+ * return the last filtered value. A trailing partial burst is ignored.
+ */
+int32_t adc_filter_update_block(struct adc_filter *f, const int16_t *samples, size_t n,
+                                size_t stride);
+
+void adc_filter_print(const struct adc_filter *f, const char *name);
+
+#endif /* ADC_FILTER_H_ */
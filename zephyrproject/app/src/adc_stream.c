@@ -0,0 +1,156 @@
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+#include "adc_stream.h"
+
+static int16_t stream_buf[2 * ADC_STREAM_HALF_LEN * ADC_STREAM_MAX_CHANNELS];
+
+static const struct device *stream_dev;
+static size_t stream_stride;
+static adc_stream_notify_t stream_notify;
+static struct adc_sequence_options stream_opts;
+static struct adc_sequence stream_seq;
+
+/* Raised by the driver when the whole buffer has been filled */
+static struct k_poll_signal done_signal;
+/* One count per half that is full and not yet handed out */
+static K_SEM_DEFINE(half_sem, 0, 2);
+
+static atomic_t half_busy;      /* bit per half: full, consumer not done with it */
+static atomic_t overruns;
+static uint8_t next_half;       /* consumer side only */
+
+/* Runs in the ADC ISR after each scan has been stored */
+static enum adc_action stream_callback(const struct device *dev,
+                                       const struct adc_sequence *sequence,
+                                       uint16_t sampling_index)
+{
+    int half;
+
+    if (sampling_index == ADC_STREAM_HALF_LEN - 1) {
+        half = 0;
+    } else if (sampling_index == 2 * ADC_STREAM_HALF_LEN - 1) {
+        half = 1;
+    } else {
+        return ADC_ACTION_CONTINUE;
+    }
+
+    if (atomic_test_and_set_bit(&half_busy, half)) {
+        /* the consumer is still on this half: it was overwritten under it */
+        atomic_inc(&overruns);
+    } else {
+        k_sem_give(&half_sem);
+        /* The driver raises done_signal in this same ISR, before the
+         * consumer can run, so the consumer always sees it.
+         */
+        if (stream_notify != NULL) {
+            stream_notify();
+        }
+    }
+    return ADC_ACTION_CONTINUE;
+}
+
+/* The driver has no wrap-around action, so a sequence covers both halves
+ * once and is re-armed from thread context as soon as it completes.
+ */
+static void stream_rearm(void)
+{
+    unsigned int signaled;
+    int result;
+    int ret;
+
+    k_poll_signal_check(&done_signal, &signaled, &result);
+    if (!signaled) {
+        return;
+    }
+    k_poll_signal_reset(&done_signal);
+    if (result != 0) {
+        printk("ADC stream sequence failed: %d\n", result);
+    }
+
+    ret = adc_read_async(stream_dev, &stream_seq, &done_signal);
+    if (ret != 0) {
+        printk("ADC stream restart failed: %d\n", ret);
+    }
+}
+
+int adc_stream_start(const struct device *dev, uint32_t channels, uint8_t resolution,
+                     uint32_t rate_hz, adc_stream_notify_t notify)
+{
+    size_t stride = POPCOUNT(channels);
+    int ret;
+
+    if (rate_hz < 10 || rate_hz > 1000) {
+        return -EINVAL;
+    }
+    if (stride == 0 || stride > ADC_STREAM_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    stream_dev = dev;
+    stream_stride = stride;
+    stream_notify = notify;
+    stream_opts = (struct adc_sequence_options) {
+        .interval_us = USEC_PER_SEC / rate_hz,
+        .callback = stream_callback,
+        .extra_samplings = 2 * ADC_STREAM_HALF_LEN - 1,
+    };
+    stream_seq = (struct adc_sequence) {
+        .options = &stream_opts,
+        .channels = channels,
+        .buffer = stream_buf,
+        .buffer_size = 2 * ADC_STREAM_HALF_LEN * stride * sizeof(stream_buf[0]),
+        .resolution = resolution,
+    };
+    k_poll_signal_init(&done_signal);
+
+    ret = adc_read_async(dev, &stream_seq, &done_signal);
+    if (ret != 0) {
+        printk("adc_read_async failed: %d\n", ret);
+    }
+    return ret;
+}
+
+size_t adc_stream_stride(void)
+{
+    return stream_stride;
+}
+
+int adc_stream_get(const int16_t **samples, k_timeout_t timeout)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    struct k_poll_event events[2];
+
+    k_poll_event_init(&events[0], K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &done_signal);
+    k_poll_event_init(&events[1], K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &half_sem);
+
+    while (1) {
+        /* Re-arm first: the ADC keeps sampling while the half is processed */
+        stream_rearm();
+
+        if (k_sem_take(&half_sem, K_NO_WAIT) == 0) {
+            *samples = &stream_buf[next_half * ADC_STREAM_HALF_LEN * stream_stride];
+            return ADC_STREAM_HALF_LEN;
+        }
+
+        events[0].state = K_POLL_STATE_NOT_READY;
+        events[1].state = K_POLL_STATE_NOT_READY;
+        if (k_poll(events, ARRAY_SIZE(events), sys_timepoint_timeout(end)) != 0) {
+            return 0;
+        }
+    }
+}
+
+void adc_stream_release(void)
+{
+    atomic_clear_bit(&half_busy, next_half);
+    next_half ^= 1;
+}
+
+uint32_t adc_stream_overruns(void)
+{
+    return (uint32_t)atomic_get(&overruns);
+}
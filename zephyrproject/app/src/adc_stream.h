@@ -0,0 +1,50 @@
+#ifndef ADC_STREAM_H_
+#define ADC_STREAM_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/types.h>
+
+/* Scans per half of the ping-pong buffer; one half is handed to the
+ * consumer while the ADC fills the other.
+ */
+#define ADC_STREAM_HALF_LEN 50
+
+/* Channels converted per scan. The buffer is sized for this many, so keep
+ * it at what the board actually wires up (MQ-135, second MQ, NTC).
+ */
+#define ADC_STREAM_MAX_CHANNELS 3
+
+/* Called from the ADC ISR each time a half-buffer is full (may be NULL). */
+typedef void (*adc_stream_notify_t)(void);
+
+/* Scan the channels in the channels bitmask continuously at rate_hz
+ * (10..1000) into the ping-pong buffer, all of them in one sequence per
+ * interval. Conversions are paced by the ADC driver's interval timer, so
+ * the rate does not depend on when the consumer runs.
+ */
+int adc_stream_start(const struct device *dev, uint32_t channels, uint8_t resolution,
+                     uint32_t rate_hz, adc_stream_notify_t notify);
+
+/* Channels per scan: the stride between two samples of one channel. The
+ * driver stores each scan in ascending channel order.
+ */
+size_t adc_stream_stride(void);
+
+/* Wait for the next full half-buffer. On success *samples points at
+ * ADC_STREAM_HALF_LEN interleaved scans (the k-th lowest channel of scan i
+ * is samples[i * adc_stream_stride() + k]) and the number of scans is
+ * returned; returns 0 on timeout. The half stays valid until
+ * adc_stream_release().
+ * Single consumer only; it must call this after every notification, as
+ * that is also where a completed sequence is re-armed.
+ */
+int adc_stream_get(const int16_t **samples, k_timeout_t timeout);
+
+/* Hand the half returned by adc_stream_get() back to the ADC. */
+void adc_stream_release(void);
+
+/* Halves the ADC refilled before the consumer released them. */
+uint32_t adc_stream_overruns(void);
+
+#endif /* ADC_STREAM_H_ */
@@ -0,0 +1,273 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "esp_at.h"
+#include "esp_uart.h"
+
+#define AT_LINE_MAX  128
+#define AT_RX_CHUNK  64
+
+enum at_parse_state {
+    AT_PARSE_LINE,      /* collecting a CR/LF terminated line */
+    AT_PARSE_IPD_DATA,  /* passing +IPD payload bytes through */
+};
+
+/* Parser state. Only the thread that owns the ESP link touches this. */
+static struct {
+    enum at_parse_state state;
+    char line[AT_LINE_MAX];
+    size_t line_len;
+    size_t ipd_remaining;
+    uint32_t pending;
+    uint32_t counts[ESP_AT_EVT_COUNT];
+    esp_at_ipd_cb_t ipd_cb;
+    void *ipd_user_data;
+} at;
+
+/* Full-line replies and the events they map to. The firmware really does
+ * print "ALREAY CONNECT" when CIPSTART hits an open link.
+ */
+static const struct {
+    const char *text;
+    uint32_t events;
+} at_lines[] = {
+    { "OK",                ESP_AT_EVT_OK },
+    { "ERROR",             ESP_AT_EVT_ERROR },
+    { "SEND OK",           ESP_AT_EVT_SEND_OK },
+    { "SEND FAIL",         ESP_AT_EVT_ERROR },
+    { "FAIL",              ESP_AT_EVT_ERROR },
+    { "CONNECT FAIL",      ESP_AT_EVT_ERROR },
+    { "ALREAY CONNECT",    ESP_AT_EVT_CONNECT },
+    { "ALREADY CONNECTED", ESP_AT_EVT_CONNECT },
+    { "WIFI CONNECTED",    ESP_AT_EVT_WIFI_CONNECTED },
+    { "ready",             ESP_AT_EVT_READY },
+    { "busy p...",         ESP_AT_EVT_BUSY },
+    { "busy s...",         ESP_AT_EVT_BUSY },
+    { "link is not",       ESP_AT_EVT_ERROR | ESP_AT_EVT_CLOSED },
+    { "too long",          ESP_AT_EVT_ERROR },
+    { "type error",        ESP_AT_EVT_ERROR },
+    { "no ip",             ESP_AT_EVT_ERROR },
+    { "DNS Fail",          ESP_AT_EVT_ERROR },
+    { "link is builded",   ESP_AT_EVT_ERROR },
+};
+
+static void at_emit(uint32_t events)
+{
+    at.pending |= events;
+    for (int i = 0; i < ESP_AT_EVT_COUNT; i++) {
+        if (events & BIT(i)) {
+            at.counts[i]++;
+        }
+    }
+}
+
+static bool at_line_ends_with(const char *suffix)
+{
+    size_t n = strlen(suffix);
+
+    return at.line_len >= n && memcmp(&at.line[at.line_len - n], suffix, n) == 0;
+}
+
+static uint32_t at_classify_line(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(at_lines); i++) {
+        if (strcmp(at.line, at_lines[i].text) == 0) {
+            return at_lines[i].events;
+        }
+    }
+    /* "<id>,CONNECT" / "<id>,CLOSED" in multi-link mode */
+    if (at_line_ends_with("CONNECT")) {
+        return ESP_AT_EVT_CONNECT;
+    }
+    if (at_line_ends_with("CLOSED")) {
+        return ESP_AT_EVT_CLOSED;
+    }
+    /* "IP ERROR", "ID ERROR", "Link typ ERROR", ... */
+    if (at_line_ends_with(" ERROR")) {
+        return ESP_AT_EVT_ERROR;
+    }
+    return 0;
+}
+
+/* Called on ':' while the line holds "+IPD,<len>" or "+IPD,<id>,<len>".
+ * Returns the payload length, or -1 if the header is malformed.
+ */
+static int at_parse_ipd_header(void)
+{
+    const char *p = &at.line[5];
+    const char *comma = strchr(p, ',');
+    int len = 0;
+
+    if (comma != NULL) {
+        p = comma + 1;
+    }
+    if (*p == '\0') {
+        return -1;
+    }
+    for (; *p != '\0'; p++) {
+        if (*p < '0' || *p > '9') {
+            return -1;
+        }
+        len = len * 10 + (*p - '0');
+    }
+    return len;
+}
+
+static void at_feed(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        if (at.state == AT_PARSE_IPD_DATA) {
+            size_t n = MIN(len - i, at.ipd_remaining);
+
+            if (at.ipd_cb != NULL) {
+                at.ipd_cb(&data[i], n, at.ipd_user_data);
+            }
+            i += n;
+            at.ipd_remaining -= n;
+            if (at.ipd_remaining == 0) {
+                at.state = AT_PARSE_LINE;
+                at_emit(ESP_AT_EVT_IPD);
+            }
+            continue;
+        }
+
+        char c = (char)data[i++];
+
+        if (c == '\r' || c == '\n') {
+            if (at.line_len == 0) {
+                continue;
+            }
+            at.line[at.line_len] = '\0';
+            printk("<<<ESP: %s\n", at.line);
+            at_emit(at_classify_line());
+            at.line_len = 0;
+            continue;
+        }
+
+        /* "> " prompt is not newline terminated */
+        if (c == '>' && at.line_len == 0) {
+            at_emit(ESP_AT_EVT_PROMPT);
+            continue;
+        }
+
+        if (c == ':' && at.line_len >= 5 && memcmp(at.line, "+IPD,", 5) == 0) {
+            at.line[at.line_len] = '\0';
+            at.line_len = 0;
+
+            int ipd_len = at_parse_ipd_header();
+
+            if (ipd_len > 0) {
+                at.ipd_remaining = ipd_len;
+                at.state = AT_PARSE_IPD_DATA;
+            }
+            continue;
+        }
+
+        if (at.line_len < sizeof(at.line) - 1) {
+            at.line[at.line_len++] = c;
+        }
+        /* overlong lines are truncated; none of the replies we match is that long */
+    }
+}
+
+/* Parse what the ISR has already queued without blocking */
+static void at_drain(void)
+{
+    uint8_t chunk[AT_RX_CHUNK];
+    int n;
+
+    while ((n = esp_uart_read(chunk, sizeof(chunk), K_NO_WAIT)) > 0) {
+        at_feed(chunk, n);
+    }
+}
+
+void esp_at_set_ipd_handler(esp_at_ipd_cb_t cb, void *user_data)
+{
+    at.ipd_cb = cb;
+    at.ipd_user_data = user_data;
+}
+
+void esp_at_send_cmd(const char *cmd)
+{
+    struct esp_uart_iov iov[] = {
+        { .base = cmd, .len = strlen(cmd) },
+        ESP_UART_IOV_LIT("\r\n"),
+    };
+
+    at_drain();
+    at.pending &= ~ESP_AT_EVT_CMD_MASK;
+
+    esp_uart_writev(iov, ARRAY_SIZE(iov));
+    printk(">>>ESP: %s\n", cmd);
+}
+
+int esp_at_wait_abortable(uint32_t mask, k_timeout_t timeout, struct k_poll_signal *abort)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    uint8_t chunk[AT_RX_CHUNK];
+
+    while (1) {
+        uint32_t hit = at.pending & mask;
+
+        if (hit != 0U) {
+            /* The link going away outranks the error reply that reports it
+             * ("link is not" is both), else the lowest set bit.
+             */
+            hit = (hit & ESP_AT_EVT_CLOSED) ? ESP_AT_EVT_CLOSED : (hit & -hit);
+            at.pending &= ~hit;
+            return (int)hit;
+        }
+
+        int n = esp_uart_read_abortable(chunk, sizeof(chunk),
+                                        sys_timepoint_timeout(end), abort);
+
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            return -ETIMEDOUT;
+        }
+        at_feed(chunk, n);
+    }
+}
+
+int esp_at_wait(uint32_t mask, k_timeout_t timeout)
+{
+    return esp_at_wait_abortable(mask, timeout, NULL);
+}
+
+int esp_at_cmd(const char *cmd, k_timeout_t timeout)
+{
+    esp_at_send_cmd(cmd);
+
+    int evt = esp_at_wait(ESP_AT_EVT_OK | ESP_AT_EVT_ERROR, timeout);
+
+    if (evt < 0) {
+        return evt;
+    }
+    return (evt == ESP_AT_EVT_OK) ? 0 : -EIO;
+}
+
+uint32_t esp_at_take(uint32_t mask)
+{
+    at_drain();
+
+    uint32_t hit = at.pending & mask;
+
+    at.pending &= ~hit;
+    return hit;
+}
+
+uint32_t esp_at_event_count(uint32_t event)
+{
+    for (int i = 0; i < ESP_AT_EVT_COUNT; i++) {
+        if (event == BIT(i)) {
+            return at.counts[i];
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef ESP_AT_H_
+#define ESP_AT_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/types.h>
+
+/* Events produced by the streaming AT response parser. Each is a bit so that
+ * callers can wait for any of several outcomes at once.
+ */
+#define ESP_AT_EVT_OK             BIT(0)  /* "OK" */
+#define ESP_AT_EVT_ERROR          BIT(1)  /* "ERROR", "FAIL", "SEND FAIL", "... ERROR", ... */
+#define ESP_AT_EVT_SEND_OK        BIT(2)  /* "SEND OK" */
+#define ESP_AT_EVT_PROMPT         BIT(3)  /* '>' data prompt after AT+CIPSEND */
+#define ESP_AT_EVT_CONNECT        BIT(4)  /* "CONNECT", "<id>,CONNECT", "ALREAY CONNECT" */
+#define ESP_AT_EVT_CLOSED         BIT(5)  /* "CLOSED", "<id>,CLOSED", "link is not" */
+#define ESP_AT_EVT_WIFI_CONNECTED BIT(6)  /* "WIFI CONNECTED" */
+#define ESP_AT_EVT_IPD            BIT(7)  /* a complete +IPD,<len>:payload frame */
+#define ESP_AT_EVT_BUSY           BIT(8)  /* "busy p..." / "busy s..." */
+#define ESP_AT_EVT_READY          BIT(9)  /* "ready" after reset */
+
+#define ESP_AT_EVT_COUNT 10
+
+/* Events that answer a single command; stale ones are dropped before a new
+ * command goes out. CONNECT/CLOSED/IPD describe link state and are kept.
+ */
+#define ESP_AT_EVT_CMD_MASK (ESP_AT_EVT_OK | ESP_AT_EVT_ERROR | ESP_AT_EVT_SEND_OK | \
+                             ESP_AT_EVT_PROMPT | ESP_AT_EVT_BUSY)
+
+/* Receives +IPD payload bytes as they stream in (may be called several
+ * times per frame). Runs in the context of the thread inside esp_at_wait().
+ */
+typedef void (*esp_at_ipd_cb_t)(const uint8_t *data, size_t len, void *user_data);
+
+void esp_at_set_ipd_handler(esp_at_ipd_cb_t cb, void *user_data);
+
+/* Parse whatever is already buffered, drop stale command events and send
+ * cmd followed by CRLF. Caller must own the ESP link.
+ */
+void esp_at_send_cmd(const char *cmd);
+
+/* Feed the UART stream through the parser until one of the events in mask
+ * has been seen or timeout expires. The matched event is consumed; events
+ * that arrive meanwhile but are not in mask stay pending. If several match,
+ * CLOSED is returned first, then the lowest bit.
+ * Returns the matched event bit, or -ETIMEDOUT.
+ */
+int esp_at_wait(uint32_t mask, k_timeout_t timeout);
+
+/* As esp_at_wait(), but gives up with -ECANCELED once abort is raised. */
+int esp_at_wait_abortable(uint32_t mask, k_timeout_t timeout, struct k_poll_signal *abort);
+
+/* Send cmd and wait for OK (0), an error reply (-EIO) or timeout (-ETIMEDOUT). */
+int esp_at_cmd(const char *cmd, k_timeout_t timeout);
+
+/* Test-and-clear pending events without blocking (buffered bytes are parsed first). */
+uint32_t esp_at_take(uint32_t mask);
+
+/* How many times each event has been seen since boot, indexed by bit number. */
+uint32_t esp_at_event_count(uint32_t event);
+
+#endif /* ESP_AT_H_ */
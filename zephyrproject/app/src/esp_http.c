@@ -0,0 +1,529 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_at.h"
+#include "esp_http.h"
+#include "esp_uart.h"
+
+static struct esp_http_stats stats;
+
+K_MEM_SLAB_DEFINE_STATIC(http_buf_slab, ESP_HTTP_REQ_MAX, ESP_HTTP_BUF_COUNT, 4);
+
+static const char *const state_names[ESP_HTTP_ST_COUNT] = {
+    [ESP_HTTP_ST_MUX]      = "mux",
+    [ESP_HTTP_ST_CONNECT]  = "connect",
+    [ESP_HTTP_ST_PROMPT]   = "prompt",
+    [ESP_HTTP_ST_SEND]     = "send",
+    [ESP_HTTP_ST_RESPONSE] = "response",
+    [ESP_HTTP_ST_CLOSE]    = "close",
+};
+
+/* Persistent link to the server */
+static struct {
+    bool mux_set;
+    bool connected;
+    bool connecting;        /* CIPSTART sent, CONNECT/CLOSED not seen yet */
+    uint32_t requests;      /* requests sent on this connection */
+    const char *host;
+    int port;
+} conn;
+
+/* Incremental HTTP/1.x response parser, fed from +IPD payloads. Responses
+ * are counted rather than matched to a single request, so a response whose
+ * wait was skipped (alarm preemption) is still consumed in order, before
+ * the next request goes out.
+ */
+enum http_resp_state {
+    RESP_STATUS,    /* "HTTP/1.1 200 OK" */
+    RESP_HEADERS,
+    RESP_BODY,
+};
+
+static struct {
+    enum http_resp_state state;
+    char line[96];
+    size_t line_len;
+    int status;
+    int32_t content_length;     /* -1: no Content-Length, body ends at close */
+    int32_t body_remaining;
+    bool close_after;
+    uint32_t completed;         /* responses finished on this connection */
+    uint32_t errors;            /* of those, not 2xx */
+    int last_status;
+    bool last_close;
+} resp;
+
+static void resp_begin(void)
+{
+    resp.state = RESP_STATUS;
+    resp.line_len = 0;
+    resp.status = 0;
+    resp.content_length = -1;
+    resp.body_remaining = 0;
+    resp.close_after = false;
+}
+
+static bool status_ok(int status)
+{
+    return status >= 200 && status <= 299;
+}
+
+static void resp_complete(void)
+{
+    resp.completed++;
+    if (!status_ok(resp.status)) {
+        resp.errors++;
+    }
+    resp.last_status = resp.status;
+    resp.last_close = resp.close_after;
+    resp_begin();
+}
+
+static void conn_opened(const char *host, int port)
+{
+    conn.connected = true;
+    conn.host = host;
+    conn.port = port;
+    conn.requests = 0;
+    resp.completed = 0;
+    resp.errors = 0;
+    resp_begin();
+}
+
+static void resp_line(void)
+{
+    resp.line[resp.line_len] = '\0';
+
+    if (resp.state == RESP_STATUS) {
+        /* HTTP/1.0 closes by default, HTTP/1.1 keeps the connection */
+        if (strncmp(resp.line, "HTTP/1.", 7) == 0 && resp.line_len >= 12) {
+            resp.close_after = (resp.line[7] == '0');
+            resp.status = atoi(&resp.line[9]);
+            resp.state = RESP_HEADERS;
+        }
+        return;
+    }
+
+    if (resp.line_len == 0) {
+        /* blank line: headers done */
+        if (resp.content_length == 0) {
+            resp_complete();
+        } else {
+            resp.body_remaining = resp.content_length;
+            resp.state = RESP_BODY;
+        }
+        return;
+    }
+
+    if (strncasecmp(resp.line, "Content-Length:", 15) == 0) {
+        resp.content_length = atoi(&resp.line[15]);
+    } else if (strncasecmp(resp.line, "Connection:", 11) == 0) {
+        if (strstr(&resp.line[11], "close") != NULL) {
+            resp.close_after = true;
+        } else if (strstr(&resp.line[11], "eep-alive") != NULL) {
+            resp.close_after = false;
+        }
+    }
+}
+
+static void http_ipd_cb(const uint8_t *data, size_t len, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    for (size_t i = 0; i < len; i++) {
+        if (resp.state == RESP_BODY) {
+            if (resp.content_length < 0) {
+                return;     /* read until CLOSED */
+            }
+            size_t n = MIN(len - i, (size_t)resp.body_remaining);
+
+            resp.body_remaining -= n;
+            i += n - 1;
+            if (resp.body_remaining == 0) {
+                resp_complete();
+            }
+            continue;
+        }
+
+        if (data[i] == '\n') {
+            resp_line();
+            resp.line_len = 0;
+        } else if (data[i] != '\r' && resp.line_len < sizeof(resp.line) - 1) {
+            resp.line[resp.line_len++] = data[i];
+        }
+    }
+}
+
+static bool abort_raised(struct k_poll_signal *abort)
+{
+    unsigned int signaled = 0;
+    int result;
+
+    if (abort != NULL) {
+        k_poll_signal_check(abort, &signaled, &result);
+    }
+    return signaled != 0;
+}
+
+/* Map a wait result onto an errno for the caller */
+static int evt_to_err(int evt)
+{
+    if (evt == -ETIMEDOUT) {
+        return -ETIMEDOUT;
+    }
+    if (evt == ESP_AT_EVT_CLOSED) {
+        return -ECONNRESET;
+    }
+    if (evt == ESP_AT_EVT_BUSY) {
+        return -EBUSY;
+    }
+    return -EIO;
+}
+
+/* Wait for the responses still owed to requests whose wait was cut short,
+ * so that a late status is never taken for the next request's. If they do
+ * not come, the response boundary is lost and the link is dropped.
+ */
+static int http_settle(struct k_poll_signal *abort)
+{
+    k_timepoint_t end = sys_timepoint_calc(K_MSEC(ESP_HTTP_RESPONSE_TIMEOUT_MS));
+    uint32_t owed = conn.requests - resp.completed;
+    uint32_t errors = resp.errors;
+    int evt = ESP_AT_EVT_IPD;
+
+    if (!conn.connected || owed == 0) {
+        return 0;
+    }
+    while (resp.completed < conn.requests && evt == ESP_AT_EVT_IPD) {
+        evt = esp_at_wait_abortable(ESP_AT_EVT_IPD | ESP_AT_EVT_CLOSED,
+                                    sys_timepoint_timeout(end), abort);
+    }
+    if (resp.completed == conn.requests) {
+        stats.late_responses += owed;
+        stats.late_errors += resp.errors - errors;
+        return 0;
+    }
+    if (evt == -ECANCELED) {
+        return -ECANCELED;
+    }
+
+    stats.late_lost += conn.requests - resp.completed;
+    if (evt == ESP_AT_EVT_CLOSED) {
+        stats.peer_closed++;
+    } else {
+        printk("Late HTTP response missing (%d), dropping the link\n", evt);
+        esp_at_cmd("AT+CIPCLOSE", K_MSEC(ESP_HTTP_CLOSE_TIMEOUT_MS));
+        esp_at_take(ESP_AT_EVT_CLOSED);
+    }
+    conn.connected = false;
+    return 0;
+}
+
+static int http_transact(const char *host, int port, const struct esp_uart_iov *req,
+                         size_t cnt, size_t len, struct k_poll_signal *abort)
+{
+    enum esp_http_state st;
+    bool done = false;
+    bool retried = false;
+    char cmd[64];
+    int ret = 0;
+    int evt;
+
+    stats.transactions++;
+    esp_at_set_ipd_handler(http_ipd_cb, NULL);
+
+    /* The server may have dropped the idle connection since last time */
+    if (esp_at_take(ESP_AT_EVT_CLOSED) && (conn.connected || conn.connecting)) {
+        if (conn.connected) {
+            stats.late_lost += conn.requests - resp.completed;
+        }
+        conn.connected = false;
+        conn.connecting = false;
+        stats.peer_closed++;
+    }
+    if (http_settle(abort) == -ECANCELED) {
+        stats.preempted++;
+        return -ECANCELED;
+    }
+    if (conn.connected && (conn.port != port || strcmp(conn.host, host) != 0)) {
+        esp_at_cmd("AT+CIPCLOSE", K_MSEC(ESP_HTTP_CLOSE_TIMEOUT_MS));
+        esp_at_take(ESP_AT_EVT_CLOSED);
+        conn.connected = false;
+    }
+
+    if (!conn.mux_set) {
+        st = ESP_HTTP_ST_MUX;
+    } else if (!conn.connected) {
+        st = ESP_HTTP_ST_CONNECT;
+    } else {
+        st = ESP_HTTP_ST_PROMPT;
+        stats.reused++;
+    }
+
+    while (!done) {
+        enum esp_http_state next = st;
+        int64_t entered_at = k_uptime_get();
+
+        stats.entered[st]++;
+
+        switch (st) {
+        case ESP_HTTP_ST_MUX:
+            /* Single-link mode; "link is builded" (ERROR) means it already is */
+            if (esp_at_cmd("AT+CIPMUX=0", K_MSEC(ESP_HTTP_MUX_TIMEOUT_MS)) == -ETIMEDOUT) {
+                stats.failed[st]++;
+            } else {
+                conn.mux_set = true;
+            }
+            next = ESP_HTTP_ST_CONNECT;
+            break;
+
+        case ESP_HTTP_ST_CONNECT:
+            /* A CIPSTART left behind by a preempted upload is still running:
+             * the ESP ignores new commands until it answers, so just wait.
+             */
+            if (!conn.connecting) {
+                esp_at_take(ESP_AT_EVT_CONNECT);
+                snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%d", host, port);
+                esp_at_send_cmd(cmd);
+                conn.connecting = true;
+            }
+            evt = esp_at_wait_abortable(ESP_AT_EVT_CONNECT | ESP_AT_EVT_ERROR | ESP_AT_EVT_CLOSED,
+                                        K_MSEC(ESP_HTTP_CONNECT_TIMEOUT_MS), abort);
+            if (evt == -ECANCELED) {
+                ret = -ECANCELED;
+                done = true;
+                break;
+            }
+            conn.connecting = false;
+            if (evt == ESP_AT_EVT_CONNECT) {
+                conn_opened(host, port);
+                stats.connects++;
+                next = ESP_HTTP_ST_PROMPT;
+            } else {
+                printk("CIPSTART failed for %s (%d)\n", host, evt);
+                stats.failed[st]++;
+                ret = evt_to_err(evt);
+                /* "CLOSED" means the ESP already dropped the link */
+                done = (evt == ESP_AT_EVT_CLOSED);
+                next = ESP_HTTP_ST_CLOSE;
+            }
+            break;
+
+        case ESP_HTTP_ST_PROMPT:
+            /* Last point where nothing has been committed to the ESP */
+            if (abort_raised(abort)) {
+                ret = -ECANCELED;
+                done = true;
+                break;
+            }
+            /* Tell ESP how many bytes we will send */
+            memcpy(cmd, "AT+CIPSEND=", 11);
+            cmd[11 + esp_http_put_u32(&cmd[11], len)] = '\0';
+            esp_at_send_cmd(cmd);
+            evt = esp_at_wait(ESP_AT_EVT_PROMPT | ESP_AT_EVT_ERROR | ESP_AT_EVT_CLOSED |
+                              ESP_AT_EVT_BUSY, K_MSEC(ESP_HTTP_PROMPT_TIMEOUT_MS));
+            if (evt == ESP_AT_EVT_PROMPT) {
+                next = ESP_HTTP_ST_SEND;
+            } else if (evt == ESP_AT_EVT_CLOSED && !retried) {
+                /* Kept-alive link went away under us: reconnect once */
+                printk("HTTP connection closed by peer, reconnecting\n");
+                esp_at_take(ESP_AT_EVT_ERROR);
+                conn.connected = false;
+                stats.peer_closed++;
+                retried = true;
+                next = ESP_HTTP_ST_CONNECT;
+            } else {
+                printk("CIPSEND prompt not received (%d)\n", evt);
+                stats.failed[st]++;
+                ret = evt_to_err(evt);
+                next = ESP_HTTP_ST_CLOSE;
+            }
+            break;
+
+        case ESP_HTTP_ST_SEND:
+            /* Once '>' is out the ESP wants exactly len bytes; not abortable */
+            printk(">>>http request \n ");
+            for (size_t i = 0; i < cnt; i++) {
+                printk("%.*s", (int)req[i].len, (const char *)req[i].base);
+            }
+            esp_uart_writev(req, cnt);
+            evt = esp_at_wait(ESP_AT_EVT_SEND_OK | ESP_AT_EVT_ERROR | ESP_AT_EVT_CLOSED,
+                              K_MSEC(ESP_HTTP_SEND_TIMEOUT_MS));
+            if (evt == ESP_AT_EVT_SEND_OK) {
+                conn.requests++;
+                next = ESP_HTTP_ST_RESPONSE;
+            } else {
+                printk("HTTP send not confirmed (%d)\n", evt);
+                stats.failed[st]++;
+                ret = evt_to_err(evt);
+                next = ESP_HTTP_ST_CLOSE;
+            }
+            break;
+
+        case ESP_HTTP_ST_RESPONSE: {
+            k_timepoint_t end = sys_timepoint_calc(K_MSEC(ESP_HTTP_RESPONSE_TIMEOUT_MS));
+            uint32_t ticket = conn.requests;
+
+            /* Content-Length tells us where each response ends */
+            evt = ESP_AT_EVT_IPD;
+            while (resp.completed < ticket && evt == ESP_AT_EVT_IPD) {
+                evt = esp_at_wait_abortable(ESP_AT_EVT_IPD | ESP_AT_EVT_CLOSED,
+                                            sys_timepoint_timeout(end), abort);
+            }
+
+            if (resp.completed >= ticket) {
+                stats.last_status = resp.last_status;
+                if (!status_ok(resp.last_status)) {
+                    printk("HTTP status %d\n", resp.last_status);
+                    stats.failed[st]++;
+                    ret = -EIO;
+                }
+                if (resp.last_close) {
+                    next = ESP_HTTP_ST_CLOSE;
+                } else {
+                    done = true;
+                }
+            } else if (evt == -ECANCELED) {
+                /* Request is delivered; its response is settled before the next one */
+                stats.responses_skipped++;
+                ret = ESP_HTTP_UNCONFIRMED;
+                done = true;
+            } else if (evt == ESP_AT_EVT_CLOSED) {
+                conn.connected = false;
+                stats.peer_closed++;
+                /* without Content-Length the close is the end of the body */
+                if (resp.state == RESP_BODY && resp.content_length < 0 &&
+                    resp.completed + 1 == ticket) {
+                    resp_complete();
+                    stats.last_status = resp.last_status;
+                } else {
+                    stats.failed[st]++;
+                    ret = -ECONNRESET;
+                }
+                done = true;
+            } else {
+                /* Response boundary lost: the link cannot be reused */
+                printk("HTTP response incomplete (%d)\n", evt);
+                stats.failed[st]++;
+                ret = evt_to_err(evt);
+                next = ESP_HTTP_ST_CLOSE;
+            }
+            break;
+        }
+
+        case ESP_HTTP_ST_CLOSE:
+            if (esp_at_cmd("AT+CIPCLOSE", K_MSEC(ESP_HTTP_CLOSE_TIMEOUT_MS)) != 0) {
+                stats.failed[st]++;
+            }
+            /* our own CIPCLOSE reports CLOSED too */
+            esp_at_take(ESP_AT_EVT_CLOSED);
+            conn.connected = false;
+            done = true;
+            break;
+
+        default:
+            done = true;
+            break;
+        }
+
+        stats.time_ms[st] += (uint32_t)(k_uptime_get() - entered_at);
+        st = next;
+    }
+
+    if (ret == -ECANCELED) {
+        stats.preempted++;
+    } else if (ret < 0) {
+        stats.errors++;
+    }
+    return ret;
+}
+
+char *esp_http_buf_alloc(k_timeout_t timeout)
+{
+    void *buf;
+
+    if (k_mem_slab_alloc(&http_buf_slab, &buf, timeout) != 0) {
+        return NULL;
+    }
+    return buf;
+}
+
+void esp_http_buf_free(char *buf)
+{
+    k_mem_slab_free(&http_buf_slab, buf);
+}
+
+size_t esp_http_put_u32(char *buf, uint32_t v)
+{
+    char tmp[ESP_HTTP_INT_MAX];
+    size_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+size_t esp_http_put_i32(char *buf, int32_t v)
+{
+    if (v < 0) {
+        buf[0] = '-';
+        /* negate in unsigned arithmetic so INT32_MIN works too */
+        return 1 + esp_http_put_u32(&buf[1], 0U - (uint32_t)v);
+    }
+    return esp_http_put_u32(buf, (uint32_t)v);
+}
+
+int esp_http_request(const char *host, int port, const struct esp_uart_iov *req, size_t cnt,
+                     struct k_poll_signal *abort)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < cnt; i++) {
+        len += req[i].len;
+    }
+    if (len > ESP_HTTP_REQ_MAX) {
+        return -ENOMEM;
+    }
+
+    return http_transact(host, port, req, cnt, len, abort);
+}
+
+void esp_http_reset(void)
+{
+    conn.mux_set = false;
+    conn.connected = false;
+    conn.connecting = false;
+}
+
+const struct esp_http_stats *esp_http_get_stats(void)
+{
+    return &stats;
+}
+
+void esp_http_print_stats(void)
+{
+    printk("HTTP: %u transactions, %u errors, %u connects, %u reused, %u peer closes, last status %d\n",
+           stats.transactions, stats.errors, stats.connects, stats.reused,
+           stats.peer_closed, stats.last_status);
+    printk("HTTP: %u preempted before send, %u responses not awaited, "
+           "late %u (%u not 2xx, %u lost)\n",
+           stats.preempted, stats.responses_skipped, stats.late_responses,
+           stats.late_errors, stats.late_lost);
+    for (int i = 0; i < ESP_HTTP_ST_COUNT; i++) {
+        uint32_t n = stats.entered[i];
+
+        printk("  %-8s entered %u failed %u total %u ms avg %u ms\n",
+               state_names[i], n, stats.failed[i], stats.time_ms[i],
+               n ? stats.time_ms[i] / n : 0);
+    }
+}
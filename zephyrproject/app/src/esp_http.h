@@ -0,0 +1,106 @@
+#ifndef ESP_HTTP_H_
+#define ESP_HTTP_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/types.h>
+
+#include "esp_uart.h"
+
+/* Upper bounds for each step of a transaction. Every state advances as soon
+ * as the ESP answers; these only limit how long a silent module can stall us.
+ */
+#define ESP_HTTP_MUX_TIMEOUT_MS       1000
+#define ESP_HTTP_CONNECT_TIMEOUT_MS   10000
+#define ESP_HTTP_PROMPT_TIMEOUT_MS    2000
+#define ESP_HTTP_SEND_TIMEOUT_MS      5000
+#define ESP_HTTP_RESPONSE_TIMEOUT_MS  3000
+#define ESP_HTTP_CLOSE_TIMEOUT_MS     1000
+
+/* Largest request esp_http_request() will send */
+#define ESP_HTTP_REQ_MAX 512
+
+/* Static pool of ESP_HTTP_REQ_MAX-byte buffers for the variable fields of
+ * a request, so no caller keeps one on its stack. Requests are sent from
+ * where their pieces are, so one buffer is enough.
+ */
+#define ESP_HTTP_BUF_COUNT 1
+
+/* Constant parts of a keep-alive GET to host:port, both literals. The
+ * caller puts the pieces of the path between them.
+ */
+#define ESP_HTTP_GET_HEAD "GET "
+#define ESP_HTTP_GET_TAIL(host, port) \
+    " HTTP/1.1\r\nHost: " host ":" STRINGIFY(port) "\r\nConnection: keep-alive\r\n\r\n"
+
+/* Longest decimal 32-bit value, sign included */
+#define ESP_HTTP_INT_MAX 11
+
+enum esp_http_state {
+    ESP_HTTP_ST_MUX,        /* AT+CIPMUX=0 -> OK (once per boot) */
+    ESP_HTTP_ST_CONNECT,    /* AT+CIPSTART -> CONNECT (only when not connected) */
+    ESP_HTTP_ST_PROMPT,     /* AT+CIPSEND=<len> -> '>' */
+    ESP_HTTP_ST_SEND,       /* request bytes -> SEND OK */
+    ESP_HTTP_ST_RESPONSE,   /* +IPD data until the HTTP response is complete */
+    ESP_HTTP_ST_CLOSE,      /* AT+CIPCLOSE -> OK (abort / server asked to close) */
+    ESP_HTTP_ST_COUNT,
+};
+
+struct esp_http_stats {
+    uint32_t entered[ESP_HTTP_ST_COUNT];
+    uint32_t failed[ESP_HTTP_ST_COUNT];   /* error reply or deadline hit */
+    uint32_t time_ms[ESP_HTTP_ST_COUNT];  /* cumulative time spent in state */
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t connects;      /* TCP connections opened */
+    uint32_t reused;        /* requests sent on an already open connection */
+    uint32_t peer_closed;   /* CLOSED reported by the ESP outside our own CIPCLOSE */
+    int last_status;        /* HTTP status code of the last response */
+    uint32_t preempted;     /* given up via the abort signal before anything was sent */
+    uint32_t responses_skipped; /* sent, but response wait cut short by the abort signal */
+    uint32_t late_responses;    /* responses to those, read before the next request */
+    uint32_t late_errors;       /* of the late responses, not 2xx */
+    uint32_t late_lost;         /* late responses that never came; link dropped */
+};
+
+/* esp_http_request(): delivered (SEND OK), but the abort signal cut the
+ * wait for the response short, so its status is not known
+ */
+#define ESP_HTTP_UNCONFIRMED 1
+
+/* Send the request made of the cnt pieces in req (normally
+ * ESP_HTTP_GET_HEAD, the path, ESP_HTTP_GET_TAIL) to host:port and wait for
+ * the complete response. The pieces go to the UART as they are; only their
+ * lengths are added up for AT+CIPSEND. The TCP connection stays open for
+ * the next request and is only re-established after the ESP reports CLOSED
+ * or the link errors. Caller must own the ESP link.
+ *
+ * If abort (may be NULL) is raised while waiting for CONNECT, or before
+ * AT+CIPSEND is issued, the call returns -ECANCELED with nothing sent. If it
+ * is raised while waiting for the response, the call returns
+ * ESP_HTTP_UNCONFIRMED at once; the next call reads that response (counted
+ * in the late_* stats) before it sends anything.
+ *
+ * Returns 0 on a 2xx response, ESP_HTTP_UNCONFIRMED, or a negative errno
+ * naming the failure.
+ */
+int esp_http_request(const char *host, int port, const struct esp_uart_iov *req, size_t cnt,
+                     struct k_poll_signal *abort);
+
+/* Write v in decimal at buf, which has room for ESP_HTTP_INT_MAX
+ * characters; no NUL. Returns the number of characters written.
+ */
+size_t esp_http_put_u32(char *buf, uint32_t v);
+size_t esp_http_put_i32(char *buf, int32_t v);
+
+/* Take a buffer from the pool (NULL if none frees up within timeout). */
+char *esp_http_buf_alloc(k_timeout_t timeout);
+void esp_http_buf_free(char *buf);
+
+/* Drop the persistent connection (e.g. after the module was reset). */
+void esp_http_reset(void);
+
+const struct esp_http_stats *esp_http_get_stats(void);
+void esp_http_print_stats(void);
+
+#endif /* ESP_HTTP_H_ */
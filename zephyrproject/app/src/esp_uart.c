@@ -0,0 +1,249 @@
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "esp_uart.h"
+
+BUILD_ASSERT(IS_POWER_OF_TWO(ESP_UART_RX_RING_SIZE),
+             "ESP_UART_RX_RING_SIZE must be a power of two");
+
+#define RX_MASK (ESP_UART_RX_RING_SIZE - 1U)
+
+static const struct device *uart_dev = DEVICE_DT_GET(ESP_UART_NODE);
+
+/* Configure UART parameters */
+static const struct uart_config uart_cfg = {
+    .baudrate = ESP_UART_BAUD,
+    .parity = UART_CFG_PARITY_NONE,
+    .stop_bits = UART_CFG_STOP_BITS_1,
+    .data_bits = UART_CFG_DATA_BITS_8,
+    .flow_ctrl = UART_CFG_FLOW_CTRL_NONE,
+};
+
+/* Single-producer (UART ISR) / single-consumer (AT layer) ring.
+ * head and tail are free-running counters; only the ISR advances head and
+ * only the reader advances tail, so no lock is needed.
+ */
+static uint8_t rx_ring[ESP_UART_RX_RING_SIZE];
+static atomic_t rx_head;
+static atomic_t rx_tail;
+static atomic_t rx_dropped;
+
+/* Given by the ISR whenever new bytes land in the ring */
+static K_SEM_DEFINE(rx_sem, 0, 1);
+
+/* Transmit in progress: the ISR feeds the pieces to the data register and
+ * the sender sleeps on tx_done until the last byte has been handed over.
+ */
+static const struct esp_uart_iov *tx_iov;
+static size_t tx_cnt;
+static size_t tx_off;           /* bytes of tx_iov[0] already sent */
+static K_SEM_DEFINE(tx_done, 0, 1);
+static K_MUTEX_DEFINE(tx_lock);
+static uint32_t tx_timeouts;
+
+static void esp_uart_tx_isr(const struct device *dev)
+{
+    while (tx_cnt > 0) {
+        int n;
+
+        if (tx_off == tx_iov->len) {
+            tx_iov++;
+            tx_cnt--;
+            tx_off = 0;
+            continue;
+        }
+        n = uart_fifo_fill(dev, (const uint8_t *)tx_iov->base + tx_off,
+                           (int)(tx_iov->len - tx_off));
+        if (n <= 0) {
+            /* data register full: the next TX interrupt continues */
+            return;
+        }
+        tx_off += n;
+    }
+
+    uart_irq_tx_disable(dev);
+    k_sem_give(&tx_done);
+}
+
+static void esp_uart_isr(const struct device *dev, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    if (!uart_irq_update(dev)) {
+        return;
+    }
+
+    while (uart_irq_rx_ready(dev)) {
+        uint32_t head = (uint32_t)atomic_get(&rx_head);
+        uint32_t space = ESP_UART_RX_RING_SIZE - (head - (uint32_t)atomic_get(&rx_tail));
+        int n;
+
+        if (space == 0U) {
+            /* Ring full: still drain the data register or the IRQ keeps firing */
+            uint8_t discard[16];
+
+            n = uart_fifo_read(dev, discard, sizeof(discard));
+            if (n <= 0) {
+                break;
+            }
+            atomic_add(&rx_dropped, n);
+            continue;
+        }
+
+        uint32_t idx = head & RX_MASK;
+
+        n = uart_fifo_read(dev, &rx_ring[idx], MIN(space, ESP_UART_RX_RING_SIZE - idx));
+        if (n <= 0) {
+            break;
+        }
+        /* Publish after the bytes are in place */
+        atomic_set(&rx_head, head + n);
+        k_sem_give(&rx_sem);
+    }
+
+    if (uart_irq_tx_ready(dev)) {
+        esp_uart_tx_isr(dev);
+    }
+}
+
+int esp_uart_init(void)
+{
+    int ret;
+
+    if (!device_is_ready(uart_dev)) {
+        printk("UART device not ready\n");
+        return -ENODEV;
+    }
+    ret = uart_configure(uart_dev, &uart_cfg);
+    if (ret == -ENOSYS) {
+        /* PTY-backed UARTs have no line settings; the far end paces itself */
+        printk("UART config not supported, using defaults\n");
+    } else if (ret) {
+        printk("UART config failed: %d\n", ret);
+        return ret;
+    }
+
+    ret = uart_irq_callback_user_data_set(uart_dev, esp_uart_isr, NULL);
+    if (ret) {
+        printk("UART IRQ callback setup failed: %d\n", ret);
+        return ret;
+    }
+    uart_irq_rx_enable(uart_dev);
+
+    return 0;
+}
+
+int esp_uart_read_abortable(uint8_t *buf, size_t len, k_timeout_t timeout,
+                            struct k_poll_signal *abort)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    struct k_poll_event events[2];
+
+    k_poll_event_init(&events[0], K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &rx_sem);
+    if (abort != NULL) {
+        k_poll_event_init(&events[1], K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, abort);
+    }
+
+    while (1) {
+        uint32_t tail = (uint32_t)atomic_get(&rx_tail);
+        uint32_t avail = (uint32_t)atomic_get(&rx_head) - tail;
+
+        if (avail > 0U) {
+            uint32_t idx = tail & RX_MASK;
+            uint32_t n = MIN((uint32_t)len, avail);
+            uint32_t first = MIN(n, ESP_UART_RX_RING_SIZE - idx);
+
+            memcpy(buf, &rx_ring[idx], first);
+            memcpy(buf + first, rx_ring, n - first);
+            atomic_set(&rx_tail, tail + n);
+            return (int)n;
+        }
+
+        /* Woken by the ISR as soon as anything arrives, or by the abort signal */
+        events[0].state = K_POLL_STATE_NOT_READY;
+        events[1].state = K_POLL_STATE_NOT_READY;
+        if (k_poll(events, (abort != NULL) ? 2 : 1, sys_timepoint_timeout(end)) != 0) {
+            return 0;
+        }
+        if (abort != NULL && events[1].state == K_POLL_STATE_SIGNALED) {
+            return -ECANCELED;
+        }
+        k_sem_take(&rx_sem, K_NO_WAIT);
+    }
+}
+
+int esp_uart_read(uint8_t *buf, size_t len, k_timeout_t timeout)
+{
+    return esp_uart_read_abortable(buf, len, timeout, NULL);
+}
+
+void esp_uart_rx_flush(void)
+{
+    atomic_set(&rx_tail, atomic_get(&rx_head));
+}
+
+uint32_t esp_uart_rx_dropped(void)
+{
+    return (uint32_t)atomic_get(&rx_dropped);
+}
+
+void esp_uart_writev(const struct esp_uart_iov *iov, size_t cnt)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < cnt; i++) {
+        len += iov[i].len;
+    }
+    if (len == 0) {
+        return;
+    }
+
+    k_mutex_lock(&tx_lock, K_FOREVER);
+
+    tx_iov = iov;
+    tx_cnt = cnt;
+    tx_off = 0;
+    k_sem_reset(&tx_done);
+    uart_irq_tx_enable(uart_dev);
+
+    /* The CPU is free for other threads while the bytes go out */
+    if (k_sem_take(&tx_done, K_MSEC(ESP_UART_TX_TIME_MS(len) + ESP_UART_TX_MARGIN_MS)) != 0) {
+        size_t sent = 0;
+
+        uart_irq_tx_disable(uart_dev);
+        /* the ISR is quiet now: whole pieces it moved past, plus tx_off of the current one */
+        for (const struct esp_uart_iov *p = iov; p < tx_iov; p++) {
+            sent += p->len;
+        }
+        if (tx_cnt > 0) {
+            sent += tx_off;
+        }
+        tx_cnt = 0;
+        tx_timeouts++;
+        printk("UART TX timed out with %u of %u bytes to go\n", (unsigned)(len - sent),
+               (unsigned)len);
+    }
+
+    k_mutex_unlock(&tx_lock);
+}
+
+void esp_uart_write(const uint8_t *buf, size_t len)
+{
+    struct esp_uart_iov iov = { .base = buf, .len = len };
+
+    esp_uart_writev(&iov, 1);
+}
+
+void esp_uart_send_str(const char *str)
+{
+    esp_uart_write((const uint8_t *)str, strlen(str));
+}
+
+uint32_t esp_uart_tx_timeouts(void)
+{
+    return tx_timeouts;
+}
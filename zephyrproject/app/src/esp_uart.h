@@ -0,0 +1,68 @@
+#ifndef ESP_UART_H_
+#define ESP_UART_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/types.h>
+
+/* UART (ESP-01): usart1 on the Nucleo, a PTY on native_sim (see app.overlay
+ * and boards/native_sim.overlay)
+ */
+#define ESP_UART_NODE DT_ALIAS(esp_uart)
+
+/* Line rate from the node's current-speed; a PTY has none and is not paced */
+#define ESP_UART_BAUD DT_PROP_OR(ESP_UART_NODE, current_speed, 115200)
+
+/* RX ring size in bytes; must be a power of two.
+ * 1 KB holds ~90 ms of back-to-back traffic at 115200 baud.
+ */
+#define ESP_UART_RX_RING_SIZE 1024
+
+/* Transmit wait: time on the wire at ESP_UART_BAUD 8N1 plus slack */
+#define ESP_UART_TX_TIME_MS(len) (((len) * 10U * 1000U) / ESP_UART_BAUD + 1U)
+#define ESP_UART_TX_MARGIN_MS 20
+
+/* Configure USART1 and start interrupt-driven reception into the RX ring. */
+int esp_uart_init(void);
+
+/* Copy up to len received bytes into buf. Blocks until at least one byte is
+ * available or timeout expires. Returns number of bytes copied (0 on timeout).
+ * Only one thread may read at a time (single consumer).
+ */
+int esp_uart_read(uint8_t *buf, size_t len, k_timeout_t timeout);
+
+/* As esp_uart_read(), but also returns -ECANCELED as soon as abort is
+ * raised (abort may be NULL).
+ */
+int esp_uart_read_abortable(uint8_t *buf, size_t len, k_timeout_t timeout,
+                            struct k_poll_signal *abort);
+
+/* Drop everything currently buffered (e.g. boot noise after AT+RST). */
+void esp_uart_rx_flush(void);
+
+/* Number of bytes lost because the RX ring was full. */
+uint32_t esp_uart_rx_dropped(void);
+
+/* One piece of a scatter-gather transmit */
+struct esp_uart_iov {
+    const void *base;
+    size_t len;
+};
+
+/* Piece for a string literal; its length is a compile-time constant */
+#define ESP_UART_IOV_LIT(s) ((struct esp_uart_iov){ .base = (s), .len = sizeof(s) - 1 })
+
+/* Transmit cnt pieces back to back, straight from where they are. The
+ * UART interrupt feeds the bytes out while the caller sleeps; returns once
+ * the last byte has been handed to the UART. Thread context only.
+ */
+void esp_uart_writev(const struct esp_uart_iov *iov, size_t cnt);
+
+/* Single-buffer and NUL-terminated-string forms of esp_uart_writev() */
+void esp_uart_write(const uint8_t *buf, size_t len);
+void esp_uart_send_str(const char *str);
+
+/* Transmits given up because the TX interrupt stopped making progress. */
+uint32_t esp_uart_tx_timeouts(void);
+
+#endif /* ESP_UART_H_ */
@@ -0,0 +1,148 @@
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+#include "gas_calib.h"
+
+static void gas_calib_save(struct k_work *work)
+{
+    struct gas_calib *c = CONTAINER_OF(work, struct gas_calib, save_work);
+    struct gas_calib_window window;
+    char key[GAS_CALIB_KEY_MAX + 8];
+    k_spinlock_key_t lock;
+    uint32_t r0;
+    int ret = 0;
+
+    /* a pair from one gas_calib_submit(), not half of the next */
+    lock = k_spin_lock(&c->save_lock);
+    window = c->save_window;
+    r0 = c->save_r0;
+    k_spin_unlock(&c->save_lock, lock);
+
+    /* NVS skips a write whose data is unchanged, so R0 costs nothing at checkpoints */
+    if (r0 != 0) {
+        snprintk(key, sizeof(key), "%s/r0", c->key);
+        ret = settings_save_one(key, &r0, sizeof(r0));
+    }
+    if (ret == 0) {
+        snprintk(key, sizeof(key), "%s/window", c->key);
+        ret = settings_save_one(key, &window, sizeof(window));
+    }
+    if (ret != 0) {
+        c->save_errors++;
+        printk("%s: save failed: %d\n", c->key, ret);
+    } else {
+        c->saves++;
+    }
+}
+
+static int gas_calib_load(const char *key, size_t len, settings_read_cb read_cb,
+                          void *cb_arg, void *param)
+{
+    struct gas_calib *c = param;
+    struct gas_calib_window window;
+    const char *next;
+    uint32_t r0;
+
+    if (settings_name_steq(key, "r0", &next) && next == NULL && len == sizeof(r0)) {
+        if (read_cb(cb_arg, &r0, sizeof(r0)) == sizeof(r0) && r0 != 0) {
+            c->r0_ohms = r0;
+        }
+    } else if (settings_name_steq(key, "window", &next) && next == NULL &&
+               len == sizeof(window)) {
+        if (read_cb(cb_arg, &window, sizeof(window)) == sizeof(window)) {
+            /* an elapsed window closes on the first reading */
+            c->window_start_ms -= MIN(window.elapsed_ms, GAS_CALIB_WINDOW_MS);
+            c->rs_max = window.rs_max;
+        }
+    }
+    return 0;
+}
+
+static void gas_calib_apply(struct gas_calib *c)
+{
+    struct sensor_value val = { .val1 = (int32_t)c->r0_ohms };
+    int ret;
+
+    ret = sensor_attr_set(c->dev, SENSOR_CHAN_GAS_RES, SENSOR_ATTR_CALIBRATION, &val);
+    if (ret != 0) {
+        printk("%s: R0 not applied: %d\n", c->key, ret);
+    }
+}
+
+int gas_calib_init(struct gas_calib *c, const struct device *dev, const char *name)
+{
+    int ret;
+
+    c->dev = dev;
+    snprintk(c->key, sizeof(c->key), "calib/%s", name);
+    k_work_init(&c->save_work, gas_calib_save);
+    c->window_start_ms = k_uptime_get_32();
+    c->checkpoint_ms = c->window_start_ms;
+
+    ret = settings_load_subtree_direct(c->key, gas_calib_load, c);
+    if (ret != 0) {
+        printk("%s: load failed: %d\n", c->key, ret);
+        return ret;
+    }
+    if (c->r0_ohms != 0) {
+        printk("%s: R0 %u ohm\n", c->key, c->r0_ohms);
+        gas_calib_apply(c);
+    }
+    if (c->rs_max != 0) {
+        printk("%s: resuming window at %u s, max Rs %u ohm\n", c->key,
+               (c->checkpoint_ms - c->window_start_ms) / 1000U, c->rs_max);
+    }
+    return 0;
+}
+
+/* Hands the state to save_work; a save still pending picks up the newer one */
+static void gas_calib_submit(struct gas_calib *c, uint32_t now_ms)
+{
+    k_spinlock_key_t lock = k_spin_lock(&c->save_lock);
+
+    c->save_r0 = c->r0_ohms;
+    c->save_window = (struct gas_calib_window) {
+        .elapsed_ms = now_ms - c->window_start_ms,
+        .rs_max = c->rs_max,
+    };
+    k_spin_unlock(&c->save_lock, lock);
+
+    c->checkpoint_ms = now_ms;
+    k_work_submit(&c->save_work);
+}
+
+void gas_calib_update(struct gas_calib *c, uint32_t rs_ohms, uint32_t now_ms)
+{
+    uint32_t r0;
+
+    c->rs_max = MAX(c->rs_max, rs_ohms);
+    if (now_ms - c->window_start_ms < GAS_CALIB_WINDOW_MS) {
+        if (now_ms - c->checkpoint_ms >= GAS_CALIB_CHECKPOINT_MS) {
+            gas_calib_submit(c, now_ms);
+        }
+        return;
+    }
+
+    r0 = (uint32_t)(((uint64_t)c->rs_max << 10) / GAS_CALIB_CLEAN_RATIO_Q10);
+    if (c->r0_ohms == 0) {
+        c->r0_ohms = r0;
+    } else {
+        /* arithmetic shift keeps the sign of a falling baseline */
+        c->r0_ohms += ((int32_t)r0 - (int32_t)c->r0_ohms) >> GAS_CALIB_EMA_SHIFT;
+    }
+    c->windows++;
+    c->window_start_ms = now_ms;
+    c->rs_max = 0;
+
+    gas_calib_apply(c);
+    gas_calib_submit(c, now_ms);
+}
+
+void gas_calib_print(const struct gas_calib *c, const char *name)
+{
+    printk("%s calib: R0 %u ohm, %u windows, window max Rs %u ohm, %u saves, %u errors\n",
+           name, c->r0_ohms, c->windows, c->rs_max, c->saves, c->save_errors);
+}
@@ -0,0 +1,59 @@
+#ifndef GAS_CALIB_H_
+#define GAS_CALIB_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/types.h>
+
+/* Background R0 calibration for a resistive gas sensor driver that reports
+ * SENSOR_CHAN_GAS_RES and takes R0 as its SENSOR_ATTR_CALIBRATION (mq135).
+ *
+ * The cleanest air of a long window, i.e. the highest Rs, is taken to be
+ * ambient outdoor air. Its R0 estimate is blended into the current one with
+ * an integer EMA, handed to the driver, and saved under the settings key
+ * "calib/<sensor>/r0" so a reboot does not start from the devicetree value.
+ * The progress of the open window is checkpointed under "calib/<sensor>/window"
+ * so a reboot does not throw away most of a day either.
+ */
+#define GAS_CALIB_WINDOW_MS (24U * 3600U * 1000U)   /* a day always has a clean spell */
+#define GAS_CALIB_CHECKPOINT_MS (3600U * 1000U)     /* window progress lost at most */
+#define GAS_CALIB_EMA_SHIFT 2           /* a new window moves R0 by 1/4 */
+#define GAS_CALIB_CLEAN_RATIO_Q10 656   /* MQ-135 Rs/R0 at 400 ppm CO2, 0.641 */
+#define GAS_CALIB_KEY_MAX 32
+
+/* Saved state of the open window */
+struct gas_calib_window {
+    uint32_t elapsed_ms;
+    uint32_t rs_max;
+};
+
+struct gas_calib {
+    const struct device *dev;
+    char key[GAS_CALIB_KEY_MAX];    /* "calib/<sensor>" */
+    uint32_t r0_ohms;           /* 0 until loaded or the first window closes */
+
+    uint32_t window_start_ms;
+    uint32_t rs_max;            /* highest Rs of the current window */
+    uint32_t checkpoint_ms;
+
+    struct k_work save_work;    /* flash writes run on the system work queue */
+    struct k_spinlock save_lock;    /* save_r0 and save_window change together */
+    uint32_t save_r0;           /* what save_work writes, taken when submitted */
+    struct gas_calib_window save_window;
+    uint32_t windows;
+    uint32_t saves;
+    uint32_t save_errors;
+};
+
+/* Load the saved R0 for sensor name, if any, and hand it to dev; resume
+ * the window that was open at reboot. Settings must be initialized.
+ * Returns 0 also when nothing was saved yet.
+ */
+int gas_calib_init(struct gas_calib *c, const struct device *dev, const char *name);
+
+/* Feed one Rs reading (ohms) taken at uptime now_ms. Never blocks. */
+void gas_calib_update(struct gas_calib *c, uint32_t rs_ohms, uint32_t now_ms);
+
+void gas_calib_print(const struct gas_calib *c, const char *name);
+
+#endif /* GAS_CALIB_H_ */
@@ -0,0 +1,265 @@
+#define DT_DRV_COMPAT winsen_mq135
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+
+#include "mq135.h"
+#include "mq135_lut.h"
+
+BUILD_ASSERT(MQ135_LUT_RATIO_SHIFT == MQ135_RATIO_SHIFT &&
+             MQ135_LUT_PPM_SHIFT == MQ135_PPM_SHIFT,
+             "generated table does not match mq135.h");
+
+struct mq135_config {
+    struct adc_dt_spec adc;
+    uint32_t rl_ohms;
+    uint32_t r0_ohms;
+};
+
+struct mq135_data {
+    uint32_t r0_ohms;       /* r0-ohms until calibrated with SENSOR_ATTR_CALIBRATION */
+    uint32_t temp_q16;      /* Rs(T) / Rs(20 C), Q16 */
+
+    int32_t counts;         /* last reading from mq135_update() */
+    bool updated;
+
+    /* converted by mq135_sample_fetch() */
+    uint32_t rs_ohms;
+    uint32_t ppm_q4;
+
+    sensor_trigger_handler_t handler;
+    const struct sensor_trigger *trigger;
+    uint32_t upper_q4;
+    uint32_t lower_q4;
+    bool above;
+};
+
+/* Rs referred to 20 C */
+static uint32_t mq135_rs_ohms(const struct device *dev, int32_t counts)
+{
+    const struct mq135_config *cfg = dev->config;
+    const struct mq135_data *data = dev->data;
+    int32_t full = BIT(cfg->adc.resolution) - 1;
+    uint64_t rs;
+
+    /* 0 counts would be an infinite Rs; the table end clamps it anyway */
+    counts = CLAMP(counts, 1, full);
+    rs = ((uint64_t)cfg->rl_ohms * (uint32_t)(full - counts)) / (uint32_t)counts;
+    return (uint32_t)MIN((rs << 16) / data->temp_q16, UINT32_MAX);
+}
+
+/* Table lookup with linear interpolation; ratios outside the table clamp */
+uint32_t mq135_ratio_to_ppm_q4(uint32_t ratio)
+{
+    size_t lo = 0;
+    size_t hi = MQ135_LUT_LEN - 1;
+
+    if (ratio <= mq135_lut_ratio[lo]) {
+        return mq135_lut_ppm[lo];
+    }
+    if (ratio >= mq135_lut_ratio[hi]) {
+        return mq135_lut_ppm[hi];
+    }
+
+    /* mq135_lut_ratio[lo] < ratio < mq135_lut_ratio[hi] */
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (ratio < mq135_lut_ratio[mid]) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+
+    return mq135_lut_ppm[lo] -
+           (uint32_t)(((uint64_t)(mq135_lut_ppm[lo] - mq135_lut_ppm[hi]) *
+                       (ratio - mq135_lut_ratio[lo])) /
+                      (mq135_lut_ratio[hi] - mq135_lut_ratio[lo]));
+}
+
+static uint32_t mq135_rs_to_ppm_q4(const struct device *dev, uint32_t rs_ohms)
+{
+    const struct mq135_data *data = dev->data;
+    uint64_t ratio = ((uint64_t)rs_ohms << MQ135_LUT_RATIO_SHIFT) / data->r0_ohms;
+
+    return mq135_ratio_to_ppm_q4((uint32_t)MIN(ratio, UINT32_MAX));
+}
+
+int32_t mq135_counts_to_ppm(const struct device *dev, int32_t counts)
+{
+    uint32_t ppm_q4 = mq135_rs_to_ppm_q4(dev, mq135_rs_ohms(dev, counts));
+
+    return (int32_t)((ppm_q4 + BIT(MQ135_LUT_PPM_SHIFT - 1)) >> MQ135_LUT_PPM_SHIFT);
+}
+
+int32_t mq135_ppm_max(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+    return (int32_t)DIV_ROUND_UP(mq135_lut_ppm[0], BIT(MQ135_LUT_PPM_SHIFT));
+}
+
+void mq135_update(const struct device *dev, int32_t counts)
+{
+    struct mq135_data *data = dev->data;
+    uint32_t ppm_q4;
+
+    data->counts = counts;
+    data->updated = true;
+
+    if (data->handler == NULL) {
+        return;
+    }
+
+    ppm_q4 = mq135_rs_to_ppm_q4(dev, mq135_rs_ohms(dev, counts));
+    if (!data->above && ppm_q4 > data->upper_q4) {
+        data->above = true;
+        data->handler(dev, data->trigger);
+    } else if (data->above && ppm_q4 < data->lower_q4) {
+        data->above = false;
+        data->handler(dev, data->trigger);
+    }
+}
+
+static int mq135_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    struct mq135_data *data = dev->data;
+
+    if (chan != SENSOR_CHAN_ALL && chan != SENSOR_CHAN_GAS_RES && chan != SENSOR_CHAN_CO2) {
+        return -ENOTSUP;
+    }
+    if (!data->updated) {
+        /* nothing handed in yet */
+        return -EAGAIN;
+    }
+
+    data->rs_ohms = mq135_rs_ohms(dev, data->counts);
+    data->ppm_q4 = mq135_rs_to_ppm_q4(dev, data->rs_ohms);
+    return 0;
+}
+
+static int mq135_channel_get(const struct device *dev, enum sensor_channel chan,
+                             struct sensor_value *val)
+{
+    struct mq135_data *data = dev->data;
+
+    switch (chan) {
+    case SENSOR_CHAN_GAS_RES:
+        val->val1 = (int32_t)data->rs_ohms;
+        val->val2 = 0;
+        return 0;
+    case SENSOR_CHAN_CO2:
+        val->val1 = (int32_t)(data->ppm_q4 >> MQ135_LUT_PPM_SHIFT);
+        val->val2 = (int32_t)(((data->ppm_q4 & BIT_MASK(MQ135_LUT_PPM_SHIFT)) * 1000000U) >>
+                              MQ135_LUT_PPM_SHIFT);
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int mq135_attr_set(const struct device *dev, enum sensor_channel chan,
+                          enum sensor_attribute attr, const struct sensor_value *val)
+{
+    struct mq135_data *data = dev->data;
+    uint32_t q4;
+
+    if (chan == SENSOR_CHAN_GAS_RES && attr == SENSOR_ATTR_CALIBRATION) {
+        if (val->val1 <= 0) {
+            return -EINVAL;
+        }
+        data->r0_ohms = (uint32_t)val->val1;
+        return 0;
+    }
+    if (chan == SENSOR_CHAN_AMBIENT_TEMP && attr == (enum sensor_attribute)MQ135_ATTR_AMBIENT_TEMP) {
+        data->temp_q16 = mq135_temp_q16(val->val1);
+        return 0;
+    }
+
+    if (chan != SENSOR_CHAN_CO2 || val->val1 < 0) {
+        return -ENOTSUP;
+    }
+    q4 = ((uint32_t)val->val1 << MQ135_LUT_PPM_SHIFT) +
+         (uint32_t)(((uint64_t)val->val2 << MQ135_LUT_PPM_SHIFT) / 1000000U);
+
+    switch (attr) {
+    case SENSOR_ATTR_UPPER_THRESH:
+        data->upper_q4 = q4;
+        return 0;
+    case SENSOR_ATTR_LOWER_THRESH:
+        data->lower_q4 = q4;
+        return 0;
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static int mq135_attr_get(const struct device *dev, enum sensor_channel chan,
+                          enum sensor_attribute attr, struct sensor_value *val)
+{
+    struct mq135_data *data = dev->data;
+
+    if (chan != SENSOR_CHAN_GAS_RES || attr != SENSOR_ATTR_CALIBRATION) {
+        return -ENOTSUP;
+    }
+    val->val1 = (int32_t)data->r0_ohms;
+    val->val2 = 0;
+    return 0;
+}
+
+static int mq135_trigger_set(const struct device *dev, const struct sensor_trigger *trig,
+                             sensor_trigger_handler_t handler)
+{
+    struct mq135_data *data = dev->data;
+
+    if (trig->type != SENSOR_TRIG_THRESHOLD || trig->chan != SENSOR_CHAN_CO2) {
+        return -ENOTSUP;
+    }
+
+    data->handler = handler;
+    data->trigger = trig;
+    data->above = false;
+    return 0;
+}
+
+static DEVICE_API(sensor, mq135_api) = {
+    .sample_fetch = mq135_sample_fetch,
+    .channel_get = mq135_channel_get,
+    .attr_set = mq135_attr_set,
+    .attr_get = mq135_attr_get,
+    .trigger_set = mq135_trigger_set,
+};
+
+static int mq135_init(const struct device *dev)
+{
+    const struct mq135_config *cfg = dev->config;
+    struct mq135_data *data = dev->data;
+
+    if (!adc_is_ready_dt(&cfg->adc)) {
+        printk("%s: ADC not ready\n", dev->name);
+        return -ENODEV;
+    }
+    if (cfg->r0_ohms == 0) {
+        return -EINVAL;
+    }
+    data->r0_ohms = cfg->r0_ohms;
+    data->temp_q16 = mq135_temp_q16(20);
+    return 0;
+}
+
+#define MQ135_DEFINE(inst)                                              \
+    static struct mq135_data mq135_data_##inst;                         \
+    static const struct mq135_config mq135_config_##inst = {            \
+        .adc = ADC_DT_SPEC_INST_GET(inst),                              \
+        .rl_ohms = DT_INST_PROP(inst, load_resistance_ohms),            \
+        .r0_ohms = DT_INST_PROP(inst, r0_ohms),                         \
+    };                                                                  \
+    SENSOR_DEVICE_DT_INST_DEFINE(inst, mq135_init, NULL, &mq135_data_##inst, \
+                                 &mq135_config_##inst, POST_KERNEL,     \
+                                 CONFIG_SENSOR_INIT_PRIORITY, &mq135_api);
+
+DT_INST_FOREACH_STATUS_OKAY(MQ135_DEFINE)
@@ -0,0 +1,64 @@
+#ifndef MQ135_H_
+#define MQ135_H_
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/types.h>
+
+/* MQ-135 gas sensor driver (winsen,mq135). It does not touch the ADC:
+ * the application scans it and pushes each filtered reading in with
+ * mq135_update(). sensor_sample_fetch() then converts the last reading and
+ * sensor_channel_get() returns
+ *   SENSOR_CHAN_GAS_RES  sensing resistance Rs, ohms
+ *   SENSOR_CHAN_CO2      CO2-equivalent concentration, ppm
+ *
+ * A SENSOR_TRIG_THRESHOLD trigger on SENSOR_CHAN_CO2 fires when the ppm
+ * rises above SENSOR_ATTR_UPPER_THRESH and again when it falls back below
+ * SENSOR_ATTR_LOWER_THRESH. The handler runs from mq135_update(), in the
+ * caller's context.
+ */
+
+/* Set on SENSOR_CHAN_AMBIENT_TEMP, degrees C in val1: Rs is referred to
+ * 20 C with the datasheet temperature curve. 20 C until set.
+ */
+enum mq135_attribute {
+    MQ135_ATTR_AMBIENT_TEMP = SENSOR_ATTR_PRIV_START,
+};
+
+/* Datasheet temperature curve at 33 %RH, fitted as
+ * 0.00035 T^2 - 0.02718 T + 1.39538 (x 1e5 below). The fit gives 0.99178
+ * at 20 C, so it is divided by that: Rs(T) / Rs(20 C) in Q16, exactly
+ * 1.0 at 20 C. Clamped to the -10..50 C the datasheet covers.
+ */
+static inline uint32_t mq135_temp_q16(int32_t celsius)
+{
+    const int64_t at_20 = 35 * 20 * 20 - 2718 * 20 + 139538;
+    int64_t fit;
+
+    celsius = CLAMP(celsius, -10, 50);
+    fit = 35 * celsius * celsius - 2718 * celsius + 139538;
+    return (uint32_t)(((fit << 16) + at_20 / 2) / at_20);
+}
+
+/* Hand the driver a new reading in raw ADC counts. */
+void mq135_update(const struct device *dev, int32_t counts);
+
+/* Convert raw ADC counts to whole ppm without changing the driver state,
+ * e.g. for every sample of a block.
+ */
+int32_t mq135_counts_to_ppm(const struct device *dev, int32_t counts);
+
+/* Fixed-point formats of mq135_ratio_to_ppm_q4() */
+#define MQ135_RATIO_SHIFT 10    /* Rs/R0 */
+#define MQ135_PPM_SHIFT   4     /* ppm */
+
+/* The curve itself: Rs/R0 in Q10 to ppm in Q4, interpolated in the
+ * generated table. Ratios outside the table (0.25..4) clamp to its ends.
+ */
+uint32_t mq135_ratio_to_ppm_q4(uint32_t ratio);
+
+/* Largest ppm the conversion returns: the top end of its table. */
+int32_t mq135_ppm_max(const struct device *dev);
+
+#endif /* MQ135_H_ */
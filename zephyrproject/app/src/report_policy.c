@@ -0,0 +1,46 @@
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+
+#include "report_policy.h"
+
+static bool outside_deadband(const struct report_policy *p, int32_t value)
+{
+    int32_t band = MAX(p->deadband_abs,
+                       (int32_t)(((int64_t)abs(p->last_value) * p->deadband_permille) / 1000));
+
+    return abs(value - p->last_value) >= band;
+}
+
+enum report_decision report_policy_eval(struct report_policy *p, int32_t value, uint32_t now_ms)
+{
+    bool above = p->above ? value > p->threshold - p->hysteresis : value > p->threshold;
+    enum report_decision d;
+
+    p->evaluated++;
+
+    if (!p->reported_once) {
+        /* first reading: nothing to compare against */
+        d = above ? REPORT_ALARM : REPORT_SEND;
+    } else if (above != p->above) {
+        p->crossings++;
+        d = REPORT_ALARM;
+    } else if (outside_deadband(p, value) || now_ms - p->last_ms >= p->heartbeat_ms) {
+        d = REPORT_SEND;
+    } else {
+        p->suppressed++;
+        return REPORT_SKIP;
+    }
+
+    p->reported_once = true;
+    p->above = above;
+    p->last_value = value;
+    p->last_ms = now_ms;
+    return d;
+}
+
+void report_policy_print(const struct report_policy *p, const char *name)
+{
+    printk("%s policy: %u readings, %u suppressed, %u threshold crossings\n",
+           name, p->evaluated, p->suppressed, p->crossings);
+}
@@ -0,0 +1,48 @@
+#ifndef REPORT_POLICY_H_
+#define REPORT_POLICY_H_
+
+#include <zephyr/types.h>
+
+/* What to do with a new reading */
+enum report_decision {
+    REPORT_SKIP,    /* within the deadband and the heartbeat has not expired */
+    REPORT_SEND,    /* moved enough, or heartbeat: queue as a periodic sample */
+    REPORT_ALARM,   /* crossed the threshold: send immediately */
+};
+
+/* Change-only reporting for one analog channel. The limits are set with
+ * REPORT_POLICY_INIT(); the rest is state owned by report_policy_eval().
+ */
+struct report_policy {
+    int32_t deadband_abs;       /* report a change of at least this many counts... */
+    uint16_t deadband_permille; /* ...or of this fraction of the last reported value */
+    uint32_t heartbeat_ms;      /* never stay silent for longer than this */
+    int32_t threshold;          /* crossing it either way reports at once */
+    int32_t hysteresis;         /* falling back below needs threshold - hysteresis */
+
+    bool reported_once;
+    bool above;
+    int32_t last_value;         /* last value that was reported */
+    uint32_t last_ms;
+
+    uint32_t evaluated;
+    uint32_t suppressed;
+    uint32_t crossings;
+};
+
+#define REPORT_POLICY_INIT(abs, permille, heartbeat, thresh, hyst) { \
+    .deadband_abs = (abs),                                         \
+    .deadband_permille = (permille),                               \
+    .heartbeat_ms = (heartbeat),                                   \
+    .threshold = (thresh),                                         \
+    .hysteresis = (hyst),                                          \
+}
+
+/* Decide whether value, read at uptime now_ms, is worth reporting. A
+ * reading that is not skipped becomes the new reference for the deadband.
+ */
+enum report_decision report_policy_eval(struct report_policy *p, int32_t value, uint32_t now_ms);
+
+void report_policy_print(const struct report_policy *p, const char *name);
+
+#endif /* REPORT_POLICY_H_ */
@@ -0,0 +1,54 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "sensor_sched.h"
+
+K_THREAD_STACK_DEFINE(sensor_wq_stack, SENSOR_SCHED_STACK_SIZE);
+static struct k_work_q sensor_wq;
+
+static void sensor_work_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct sensor_desc *sensor = CONTAINER_OF(dwork, struct sensor_desc, work);
+
+    sensor->runs++;
+    sensor->sample(sensor);
+
+    if (sensor->period_ms != 0) {
+        /* Schedule from the previous deadline, not from now, so runtime
+         * and queueing delay do not accumulate into drift.
+         */
+        sensor->next_ms += sensor->period_ms;
+        k_work_schedule_for_queue(&sensor_wq, &sensor->work,
+                                  K_MSEC(MAX(sensor->next_ms - k_uptime_get(), 0)));
+    }
+}
+
+void sensor_sched_start(void)
+{
+    const struct k_work_queue_config cfg = {
+        .name = "sensors",
+    };
+
+    k_work_queue_start(&sensor_wq, sensor_wq_stack, K_THREAD_STACK_SIZEOF(sensor_wq_stack),
+                       SENSOR_SCHED_PRIORITY, &cfg);
+}
+
+void sensor_sched_add(struct sensor_desc *sensor)
+{
+    k_work_init_delayable(&sensor->work, sensor_work_handler);
+    if (sensor->period_ms != 0) {
+        sensor->next_ms = k_uptime_get() + sensor->period_ms;
+        k_work_schedule_for_queue(&sensor_wq, &sensor->work, K_MSEC(sensor->period_ms));
+    }
+}
+
+void sensor_sched_trigger(struct sensor_desc *sensor, k_timeout_t delay)
+{
+    k_work_reschedule_for_queue(&sensor_wq, &sensor->work, delay);
+}
+
+void sensor_sched_print(const struct sensor_desc *sensor)
+{
+    printk("Sensor %s: %u runs\n", sensor->name, sensor->runs);
+}
@@ -0,0 +1,47 @@
+#ifndef SENSOR_SCHED_H_
+#define SENSOR_SCHED_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/types.h>
+
+/* Every sensor's sample routine runs from one work queue, so a sensor
+ * costs a descriptor instead of a thread and its stack. Routines must not
+ * block; the network is reached only through the uplink queues.
+ */
+#define SENSOR_SCHED_STACK_SIZE 1024
+#define SENSOR_SCHED_PRIORITY 4     /* above the uplink thread */
+
+struct sensor_desc;
+
+typedef void (*sensor_sample_fn)(struct sensor_desc *sensor);
+
+struct sensor_desc {
+    const char *name;
+    uint32_t period_ms;         /* 0: runs only when triggered */
+    sensor_sample_fn sample;
+
+    struct k_work_delayable work;
+    int64_t next_ms;            /* next periodic run, kept drift-free */
+    uint32_t runs;
+};
+
+#define SENSOR_DESC_INIT(_name, _period_ms, _sample) { \
+    .name = (_name),                                   \
+    .period_ms = (_period_ms),                         \
+    .sample = (_sample),                               \
+}
+
+/* Start the sensor work queue. Call once before adding sensors. */
+void sensor_sched_start(void);
+
+/* Register a sensor; periodic ones get their first run one period from now. */
+void sensor_sched_add(struct sensor_desc *sensor);
+
+/* Run a triggered (period_ms 0) sensor's routine after delay, restarting
+ * the delay if it is already pending. Safe from ISRs.
+ */
+void sensor_sched_trigger(struct sensor_desc *sensor, k_timeout_t delay);
+
+void sensor_sched_print(const struct sensor_desc *sensor);
+
+#endif /* SENSOR_SCHED_H_ */
@@ -0,0 +1,561 @@
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "adc_filter.h"
+#include "adc_stream.h"
+#include "gas_calib.h"
+#include "mq135.h"
+#include "report_policy.h"
+#include "sensor_sched.h"
+#include "sensor_table.h"
+#include "uplink.h"
+#include "window_stats.h"
+
+/* All ADC sensors share one scan sequence */
+BUILD_ASSERT(SENSOR_ADC_COUNT <= ADC_STREAM_MAX_CHANNELS, "more ADC sensors than scan slots");
+
+#define POLICY_PRINT_EVERY 12   /* readings between counter prints */
+#define AMBIENT_PERIOD_MS 60000 /* ambient temperature moves slowly */
+
+enum report_mode {
+    REPORT_MODE_READINGS,   /* order of the report-mode enum in the binding */
+    REPORT_MODE_SUMMARY,
+};
+
+struct adc_sensor {
+    const char *name;
+    struct adc_dt_spec spec;
+    struct gpio_dt_spec indicator;
+    const struct device *gas;   /* converts counts to ppm, or NULL for raw counts */
+    const struct device *ambient;   /* temperature for the gas sensor, or NULL */
+    uint32_t rate_hz;
+    uint8_t report_mode;    /* enum report_mode */
+    uint32_t window_samples;
+
+    uint32_t ambient_ms;    /* uptime of the last ambient temperature read */
+    uint8_t id;
+    uint8_t slot;           /* position of the channel within a scan */
+    uint8_t decimate;       /* scans per sample of this sensor */
+    int32_t value;          /* latest filtered reading, ADC counts */
+    struct sensor_trigger gas_trigger;
+    struct gas_calib calib;
+    struct adc_filter filter;
+    struct report_policy policy;
+    struct window_stats window;
+};
+
+struct gpio_sensor {
+    struct sensor_desc desc;
+    struct gpio_dt_spec spec;
+    uint32_t debounce_ms;
+
+    uint8_t id;
+    int state;
+    struct gpio_callback cb;
+    /* interrupt mode: uptime of the first edge of a bounce burst, taken in the ISR */
+    atomic_t edge_ms;
+    atomic_t edge_pending;
+    /* poll mode: consecutive samples that disagreed with state */
+    uint16_t differing;
+    uint32_t candidate_ms;
+};
+
+static void adc_scan_sample(struct sensor_desc *desc);
+static void gpio_sensor_sample(struct sensor_desc *desc);
+
+#define SENSOR_INFO(node) {                                             \
+    .name = DT_PROP(node, sensor_name),                                 \
+    .endpoint = DT_PROP(node, endpoint),                                \
+    .param = DT_PROP(node, value_param),                                \
+    .name_len = sizeof(DT_PROP(node, sensor_name)) - 1,                 \
+    .endpoint_len = sizeof(DT_PROP(node, endpoint)) - 1,                \
+    .param_len = sizeof(DT_PROP(node, value_param)) - 1,                \
+},
+
+#define ADC_SENSOR(node) {                                              \
+    .name = DT_PROP(node, sensor_name),                                 \
+    .spec = ADC_DT_SPEC_GET(node),                                      \
+    .indicator = GPIO_DT_SPEC_GET_OR(node, indicator_gpios, {0}),       \
+    .gas = COND_CODE_1(DT_NODE_HAS_PROP(node, gas_sensor),              \
+                       (DEVICE_DT_GET(DT_PHANDLE(node, gas_sensor))), (NULL)), \
+    .ambient = COND_CODE_1(DT_NODE_HAS_PROP(node, ambient_temp_sensor),  \
+                           (DEVICE_DT_GET(DT_PHANDLE(node, ambient_temp_sensor))), (NULL)), \
+    .rate_hz = DT_PROP(node, sample_rate_hz),                           \
+    .report_mode = DT_ENUM_IDX(node, report_mode),                      \
+    .window_samples = DT_PROP(node, window_s) * DT_PROP(node, sample_rate_hz), \
+    .filter = ADC_FILTER_INIT(DT_PROP(node, ema_shift)),                \
+    .policy = REPORT_POLICY_INIT(DT_PROP(node, deadband_abs),           \
+                                 DT_PROP(node, deadband_permille),      \
+                                 DT_PROP(node, heartbeat_ms),           \
+                                 DT_PROP(node, threshold),              \
+                                 DT_PROP(node, hysteresis)),            \
+},
+
+#define GPIO_SENSOR(node) {                                             \
+    .desc = SENSOR_DESC_INIT(DT_PROP(node, sensor_name),                \
+                             DT_PROP(node, sample_period_ms), gpio_sensor_sample), \
+    .spec = GPIO_DT_SPEC_GET(node, gpios),                              \
+    .debounce_ms = DT_PROP(node, debounce_ms),                          \
+},
+
+static const struct sensor_info sensor_infos[SENSOR_COUNT] = {
+    DT_FOREACH_STATUS_OKAY(env_monitor_adc_sensor, SENSOR_INFO)
+    DT_FOREACH_STATUS_OKAY(env_monitor_gpio_sensor, SENSOR_INFO)
+};
+
+static struct adc_sensor adc_sensors[SENSOR_ADC_COUNT] = {
+    DT_FOREACH_STATUS_OKAY(env_monitor_adc_sensor, ADC_SENSOR)
+};
+
+static struct gpio_sensor gpio_sensors[SENSOR_GPIO_COUNT] = {
+    DT_FOREACH_STATUS_OKAY(env_monitor_gpio_sensor, GPIO_SENSOR)
+};
+
+/* Runs once per half-buffer of the scan, for every ADC sensor */
+static struct sensor_desc adc_scan = SENSOR_DESC_INIT("adc scan", 0, adc_scan_sample);
+
+const struct sensor_info *sensor_info_get(int id)
+{
+    return &sensor_infos[id];
+}
+
+/* ADC ISR: a half-buffer of scans is ready */
+static void adc_scan_notify(void)
+{
+    sensor_sched_trigger(&adc_scan, K_NO_WAIT);
+}
+
+/* Filters this sensor's column of a half-buffer of n scans */
+static void adc_sensor_filter(struct adc_sensor *s, const int16_t *scans, int n, size_t stride)
+{
+    const int16_t *column = &scans[s->slot];
+    size_t step = stride * s->decimate;
+    size_t count = n / s->decimate;
+
+    if (s->gas != NULL) {
+        /* Summaries are in ppm too; the table makes this cheap per sample */
+        int16_t ppm[ADC_STREAM_HALF_LEN];
+
+        for (size_t i = 0; i < count; i++) {
+            ppm[i] = MIN(mq135_counts_to_ppm(s->gas, column[i * step]), INT16_MAX);
+        }
+        window_stats_add_block(&s->window, ppm, count, 1);
+    } else {
+        window_stats_add_block(&s->window, column, count, step);
+    }
+    s->value = adc_filter_update_block(&s->filter, column, count, step);
+}
+
+/* Gas sensor threshold trigger: runs from mq135_update() on the work queue */
+static void adc_sensor_gas_trigger(const struct device *dev, const struct sensor_trigger *trig)
+{
+    struct adc_sensor *s = CONTAINER_OF(trig, struct adc_sensor, gas_trigger);
+    struct sensor_value ppm;
+
+    if (sensor_sample_fetch(dev) == 0 &&
+        sensor_channel_get(dev, SENSOR_CHAN_CO2, &ppm) == 0) {
+        gpio_pin_set_dt(&s->indicator, ppm.val1 > s->policy.threshold);
+    }
+}
+
+/* Hands the gas sensor the ambient temperature, every AMBIENT_PERIOD_MS */
+static void adc_sensor_ambient(struct adc_sensor *s, uint32_t now_ms)
+{
+    struct sensor_value temp;
+    int ret;
+
+    if (s->ambient == NULL || now_ms - s->ambient_ms < AMBIENT_PERIOD_MS) {
+        return;
+    }
+    s->ambient_ms = now_ms;
+
+    ret = sensor_sample_fetch_chan(s->ambient, SENSOR_CHAN_AMBIENT_TEMP);
+    if (ret == 0) {
+        ret = sensor_channel_get(s->ambient, SENSOR_CHAN_AMBIENT_TEMP, &temp);
+    }
+    if (ret == 0) {
+        ret = sensor_attr_set(s->gas, SENSOR_CHAN_AMBIENT_TEMP,
+                              (enum sensor_attribute)MQ135_ATTR_AMBIENT_TEMP, &temp);
+    }
+    if (ret != 0) {
+        /* the driver keeps the last temperature it was given */
+        printk("%s: ambient temperature not applied: %d\n", s->name, ret);
+    }
+}
+
+/* The filtered reading in the units the sensor reports in */
+static int32_t adc_sensor_value(struct adc_sensor *s)
+{
+    struct sensor_value ppm;
+    struct sensor_value rs;
+    int ret;
+
+    if (s->gas == NULL) {
+        return s->value;
+    }
+
+    adc_sensor_ambient(s, k_uptime_get_32());
+    mq135_update(s->gas, s->value);
+    ret = sensor_sample_fetch(s->gas);
+    if (ret == 0) {
+        ret = sensor_channel_get(s->gas, SENSOR_CHAN_CO2, &ppm);
+    }
+    if (ret == 0) {
+        ret = sensor_channel_get(s->gas, SENSOR_CHAN_GAS_RES, &rs);
+    }
+    if (ret != 0) {
+        printk("%s: gas conversion failed: %d\n", s->name, ret);
+        return 0;
+    }
+
+    printk("%s: %d counts, Rs %d ohm\n", s->name, s->value, rs.val1);
+    /* Tracks the baseline from the same readings; may hand the driver a new R0 */
+    gas_calib_update(&s->calib, (uint32_t)rs.val1, k_uptime_get_32());
+    return ppm.val1;
+}
+
+/* Reports the reading adc_sensor_filter() left behind */
+static void adc_sensor_report(struct adc_sensor *s)
+{
+    struct window_summary summary;
+    int32_t value = adc_sensor_value(s);
+
+    printk("%s: %d\n", s->name, value);
+    if (s->indicator.port != NULL && s->gas == NULL) {
+        gpio_pin_set_dt(&s->indicator, value > s->policy.threshold);
+    }
+
+    /* Hand the reading to the uplink thread; never waits on the network */
+    switch (report_policy_eval(&s->policy, value, k_uptime_get_32())) {
+    case REPORT_ALARM:
+        uplink_alarm(s->id, value, k_uptime_get_32());
+        break;
+    case REPORT_SEND:
+        if (s->report_mode == REPORT_MODE_READINGS) {
+            uplink_submit(s->id, value);
+        }
+        break;
+    case REPORT_SKIP:
+        break;
+    }
+    if ((s->policy.evaluated % POLICY_PRINT_EVERY) == 0) {
+        report_policy_print(&s->policy, s->name);
+        adc_filter_print(&s->filter, s->name);
+        if (s->gas != NULL) {
+            gas_calib_print(&s->calib, s->name);
+        }
+    }
+
+    if (s->window.count >= s->window_samples) {
+        window_stats_summarize(&s->window, k_uptime_get_32(), &summary);
+        printk("%s window: n %u min %d max %d mean %d var %u p50 %d p95 %d p99 %d\n",
+               s->name, summary.count, summary.min, summary.max, summary.mean,
+               summary.variance, summary.p50, summary.p95, summary.p99);
+        if (s->report_mode == REPORT_MODE_SUMMARY) {
+            uplink_submit_summary(s->id, &summary);
+        }
+    }
+}
+
+/* Splits each completed half-buffer of scans into one reading per sensor */
+static void adc_scan_sample(struct sensor_desc *desc)
+{
+    size_t stride = adc_stream_stride();
+    const int16_t *scans;
+    int n;
+
+    /* Paced by the ADC, not by the work queue or the network */
+    while ((n = adc_stream_get(&scans, K_NO_WAIT)) > 0) {
+        /* Column by column, so the half goes back to the ADC before any reporting */
+        for (int i = 0; i < SENSOR_ADC_COUNT; i++) {
+            adc_sensor_filter(&adc_sensors[i], scans, n, stride);
+        }
+        adc_stream_release();
+
+        for (int i = 0; i < SENSOR_ADC_COUNT; i++) {
+            adc_sensor_report(&adc_sensors[i]);
+        }
+    }
+
+    if ((desc->runs % POLICY_PRINT_EVERY) == 0) {
+        sensor_sched_print(desc);
+        printk("ADC stream: %u overruns\n", adc_stream_overruns());
+    }
+}
+
+/* threshold and hysteresis are in ppm for a gas sensor; the driver's
+ * threshold trigger drives the indicator.
+ */
+static int adc_sensor_gas_init(struct adc_sensor *s)
+{
+    struct sensor_value upper = { .val1 = s->policy.threshold };
+    struct sensor_value lower = { .val1 = s->policy.threshold - s->policy.hysteresis };
+    int ret;
+
+    if (!device_is_ready(s->gas)) {
+        printk("%s: gas sensor not ready\n", s->name);
+        return -ENODEV;
+    }
+    if (s->ambient != NULL) {
+        if (!device_is_ready(s->ambient)) {
+            printk("%s: ambient temperature sensor not ready\n", s->name);
+            return -ENODEV;
+        }
+        /* the first reading fetches it */
+        s->ambient_ms = k_uptime_get_32() - AMBIENT_PERIOD_MS;
+    }
+    /* A missing or unreadable baseline only means starting from r0-ohms */
+    gas_calib_init(&s->calib, s->gas, s->name);
+    if (s->indicator.port == NULL) {
+        return 0;
+    }
+
+    ret = sensor_attr_set(s->gas, SENSOR_CHAN_CO2, SENSOR_ATTR_UPPER_THRESH, &upper);
+    if (ret == 0) {
+        ret = sensor_attr_set(s->gas, SENSOR_CHAN_CO2, SENSOR_ATTR_LOWER_THRESH, &lower);
+    }
+    if (ret == 0) {
+        s->gas_trigger = (struct sensor_trigger) {
+            .type = SENSOR_TRIG_THRESHOLD,
+            .chan = SENSOR_CHAN_CO2,
+        };
+        ret = sensor_trigger_set(s->gas, &s->gas_trigger, adc_sensor_gas_trigger);
+    }
+    if (ret != 0) {
+        printk("%s: gas sensor threshold setup failed: %d\n", s->name, ret);
+    }
+    return ret;
+}
+
+static int adc_sensor_init(struct adc_sensor *s)
+{
+    uint32_t range;
+    int ret;
+
+    if (!adc_is_ready_dt(&s->spec)) {
+        printk("%s: ADC device not ready\n", s->name);
+        return -ENODEV;
+    }
+    ret = adc_channel_setup_dt(&s->spec);
+    if (ret != 0) {
+        printk("%s: adc_channel_setup failed: %d\n", s->name, ret);
+        return ret;
+    }
+
+    if (s->indicator.port != NULL) {
+        if (!gpio_is_ready_dt(&s->indicator)) {
+            printk("%s: indicator not ready\n", s->name);
+            return -ENODEV;
+        }
+        gpio_pin_configure_dt(&s->indicator, GPIO_OUTPUT_INACTIVE);
+    }
+
+    if (s->gas != NULL) {
+        ret = adc_sensor_gas_init(s);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    /* Summaries are in the units the sensor reports in: size the histogram to match */
+    range = BIT(s->spec.resolution);
+    if (s->gas != NULL) {
+        range = mq135_ppm_max(s->gas) + 1;
+    }
+    window_stats_init(&s->window, range);
+    return 0;
+}
+
+/* One sequence converts every ADC sensor's channel per scan, at the highest
+ * sensor rate; slower sensors use every decimate-th scan.
+ */
+static int adc_scan_init(void)
+{
+    const struct adc_dt_spec *first = &adc_sensors[0].spec;
+    uint32_t channels = 0;
+    uint32_t rate_hz = 0;
+    int ret;
+
+    for (int i = 0; i < SENSOR_ADC_COUNT; i++) {
+        struct adc_sensor *s = &adc_sensors[i];
+
+        if (s->spec.dev != first->dev || s->spec.resolution != first->resolution) {
+            printk("%s: all ADC sensors must share one ADC and resolution\n", s->name);
+            return -EINVAL;
+        }
+        if (channels & BIT(s->spec.channel_id)) {
+            printk("%s: ADC channel %u used twice\n", s->name, s->spec.channel_id);
+            return -EINVAL;
+        }
+        channels |= BIT(s->spec.channel_id);
+        rate_hz = MAX(rate_hz, s->rate_hz);
+
+        ret = adc_sensor_init(s);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    for (int i = 0; i < SENSOR_ADC_COUNT; i++) {
+        struct adc_sensor *s = &adc_sensors[i];
+        uint32_t decimate = rate_hz / s->rate_hz;
+
+        /* each half must give every sensor whole bursts */
+        if (rate_hz % s->rate_hz != 0 || ADC_STREAM_HALF_LEN % decimate != 0 ||
+            (ADC_STREAM_HALF_LEN / decimate) % ADC_FILTER_BURST != 0) {
+            printk("%s: %u Hz does not fit a %u Hz scan\n", s->name, s->rate_hz, rate_hz);
+            return -EINVAL;
+        }
+        if (s->window_samples > WINDOW_STATS_MAX_COUNT) {
+            printk("%s: summary window too long\n", s->name);
+            return -EINVAL;
+        }
+        s->decimate = decimate;
+        s->slot = POPCOUNT(channels & BIT_MASK(s->spec.channel_id));
+    }
+
+    sensor_sched_add(&adc_scan);
+
+    /* Scanned continuously; each full half-buffer triggers adc_scan_sample() */
+    return adc_stream_start(first->dev, channels, first->resolution, rate_hz, adc_scan_notify);
+}
+
+/* Acts on a debounced change of level */
+static void gpio_sensor_changed(struct gpio_sensor *s, int val, uint32_t since_ms)
+{
+    s->state = val;
+    if (val == 1) {
+        printk("%s: detected!\n", s->desc.name);
+        /* Alarm class: jumps ahead of queued periodic readings */
+        uplink_alarm(s->id, 1, since_ms);
+    } else {
+        printk("%s: clear\n", s->desc.name);
+    }
+}
+
+/* Edge ISR: only timestamps the edge and (re)starts the debounce timer */
+static void gpio_sensor_isr(const struct device *dev, struct gpio_callback *cb,
+                            gpio_port_pins_t pins)
+{
+    struct gpio_sensor *s = CONTAINER_OF(cb, struct gpio_sensor, cb);
+
+    if (!atomic_test_and_set_bit(&s->edge_pending, 0)) {
+        atomic_set(&s->edge_ms, (atomic_val_t)k_uptime_get_32());
+    }
+    sensor_sched_trigger(&s->desc, K_MSEC(s->debounce_ms));
+}
+
+/* Interrupt mode: runs once the pin has been quiet for debounce_ms.
+ * Poll mode: runs every period; a new level must be seen for debounce_ms.
+ */
+static void gpio_sensor_sample(struct sensor_desc *desc)
+{
+    struct gpio_sensor *s = CONTAINER_OF(desc, struct gpio_sensor, desc);
+    uint32_t now = k_uptime_get_32();
+    int val;
+
+    val = gpio_pin_get_dt(&s->spec);
+    if (val < 0) {
+        printk("Error %d: failed to read %s pin\n", val, desc->name);
+        return;
+    }
+
+    if (desc->period_ms == 0) {
+        uint32_t edge_ms = now;
+
+        /* No edge pending means the boot-time level check */
+        if (atomic_test_and_clear_bit(&s->edge_pending, 0)) {
+            edge_ms = (uint32_t)atomic_get(&s->edge_ms);
+        }
+        if (val != s->state) {
+            gpio_sensor_changed(s, val, edge_ms);
+        }
+        return;
+    }
+
+    if (val == s->state) {
+        s->differing = 0;
+        return;
+    }
+    if (s->differing++ == 0) {
+        s->candidate_ms = now;
+    }
+    if (s->differing * desc->period_ms >= s->debounce_ms) {
+        s->differing = 0;
+        gpio_sensor_changed(s, val, s->candidate_ms);
+    }
+}
+
+static int gpio_sensor_init(struct gpio_sensor *s)
+{
+    int ret;
+
+    if (!gpio_is_ready_dt(&s->spec)) {
+        printk("Error: GPIO device not ready for %s\n", s->desc.name);
+        return -ENODEV;
+    }
+    ret = gpio_pin_configure_dt(&s->spec, GPIO_INPUT);
+    if (ret != 0) {
+        printk("Error %d: failed to configure %s pin\n", ret, s->desc.name);
+        return ret;
+    }
+
+    sensor_sched_add(&s->desc);
+    if (s->desc.period_ms != 0) {
+        return 0;
+    }
+
+    /* Interrupt mode: edges on both sides, debounced in gpio_sensor_sample() */
+    gpio_init_callback(&s->cb, gpio_sensor_isr, BIT(s->spec.pin));
+    ret = gpio_add_callback(s->spec.port, &s->cb);
+    if (ret != 0) {
+        printk("Error %d: failed to add %s callback\n", ret, s->desc.name);
+        return ret;
+    }
+    ret = gpio_pin_interrupt_configure_dt(&s->spec, GPIO_INT_EDGE_BOTH);
+    if (ret != 0) {
+        printk("Error %d: failed to configure %s interrupt\n", ret, s->desc.name);
+        return ret;
+    }
+
+    /* A level already active at boot produces no edge; check it once */
+    sensor_sched_trigger(&s->desc, K_NO_WAIT);
+    return 0;
+}
+
+int sensor_table_init(void)
+{
+    int first_err = 0;
+    int ret;
+
+    for (int i = 0; i < SENSOR_ADC_COUNT; i++) {
+        adc_sensors[i].id = i;
+    }
+    if (SENSOR_ADC_COUNT > 0) {
+        ret = adc_scan_init();
+        if (ret != 0) {
+            /* the flame alarm does not depend on the ADC: carry on */
+            printk("ADC sensors disabled: %d\n", ret);
+            first_err = ret;
+        }
+    }
+
+    for (int i = 0; i < SENSOR_GPIO_COUNT; i++) {
+        gpio_sensors[i].id = SENSOR_ADC_COUNT + i;
+        ret = gpio_sensor_init(&gpio_sensors[i]);
+        if (ret != 0) {
+            printk("%s disabled: %d\n", gpio_sensors[i].desc.name, ret);
+            first_err = first_err ? first_err : ret;
+        }
+    }
+
+    printk("%d sensors configured\n", SENSOR_COUNT);
+    return first_err;
+}
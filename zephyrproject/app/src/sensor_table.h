@@ -0,0 +1,35 @@
+#ifndef SENSOR_TABLE_H_
+#define SENSOR_TABLE_H_
+
+#include <zephyr/devicetree.h>
+#include <zephyr/types.h>
+
+/* The sensors are the okay devicetree nodes with these compatibles (see
+ * dts/bindings). Sensor ids number the ADC sensors first, then the GPIO
+ * sensors, each in devicetree order.
+ */
+#define SENSOR_ADC_COUNT  DT_NUM_INST_STATUS_OKAY(env_monitor_adc_sensor)
+#define SENSOR_GPIO_COUNT DT_NUM_INST_STATUS_OKAY(env_monitor_gpio_sensor)
+#define SENSOR_COUNT      (SENSOR_ADC_COUNT + SENSOR_GPIO_COUNT)
+
+/* How the server knows a sensor. The strings are devicetree literals, so
+ * their lengths are known at compile time.
+ */
+struct sensor_info {
+    const char *name;       /* sensor= in batch and summary requests */
+    const char *endpoint;   /* path for single readings and alarms */
+    const char *param;      /* query parameter carrying the value there */
+    uint8_t name_len;
+    uint8_t endpoint_len;
+    uint8_t param_len;
+};
+
+const struct sensor_info *sensor_info_get(int id);
+
+/* Configure every sensor's hardware and register its routine with the
+ * sensor scheduler, which must already be started. A sensor that fails to
+ * set up does not keep the others from running; the first error is returned.
+ */
+int sensor_table_init(void);
+
+#endif /* SENSOR_TABLE_H_ */
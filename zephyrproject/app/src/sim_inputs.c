@@ -0,0 +1,71 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/printk.h>
+
+/* Stimulus for native_sim runs (boards/native_sim.overlay): the MQ-135
+ * divider sits at a clean-air level with a gas plume at the end of every
+ * plume period, and the flame input fires once per flame period. That is
+ * enough to exercise readings, summaries and both alarm paths end to end.
+ */
+#define SIM_AIR_MV          1300    /* ~240 ppm with RL 10k, R0 20k */
+#define SIM_PLUME_MV        2000    /* ~2600 ppm, above the alarm threshold */
+#define SIM_RIPPLE_MV       10
+#define SIM_PLUME_PERIOD_S  90
+#define SIM_PLUME_S         10
+#define SIM_FLAME_PERIOD_S  120
+#define SIM_FLAME_S         3
+
+#define SIM_SMOKE_NODE DT_NODELABEL(smoke)
+#define SIM_FLAME_NODE DT_NODELABEL(flame_input)
+
+static const struct device *const sim_adc = DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(SIM_SMOKE_NODE));
+static const struct device *const sim_gpio = DEVICE_DT_GET(DT_GPIO_CTLR(SIM_FLAME_NODE, gpios));
+
+static struct k_work_delayable sim_flame_work;
+
+/* Called by the emulated ADC for every conversion of the MQ-135 channel */
+static int sim_air_mv(const struct device *dev, unsigned int chan, void *data, uint32_t *result)
+{
+    uint32_t now = k_uptime_get_32();
+    uint32_t phase = (now / 1000U) % SIM_PLUME_PERIOD_S;
+    /* a small sawtooth so deadband and statistics have something to do */
+    int32_t ripple = (int32_t)((now / 100U) % (2U * SIM_RIPPLE_MV + 1U)) - SIM_RIPPLE_MV;
+
+    ARG_UNUSED(dev);
+    ARG_UNUSED(chan);
+    ARG_UNUSED(data);
+
+    *result = (phase >= SIM_PLUME_PERIOD_S - SIM_PLUME_S ? SIM_PLUME_MV : SIM_AIR_MV) + ripple;
+    return 0;
+}
+
+static void sim_flame_update(struct k_work *work)
+{
+    uint32_t phase = (k_uptime_get_32() / 1000U) % SIM_FLAME_PERIOD_S;
+    bool flame = phase >= SIM_FLAME_PERIOD_S - SIM_FLAME_S;
+
+    /* Active low; fails harmlessly until sensor_table_init() made it an input */
+    gpio_emul_input_set(sim_gpio, DT_GPIO_PIN(SIM_FLAME_NODE, gpios), flame ? 0 : 1);
+    k_work_schedule(k_work_delayable_from_work(work), K_SECONDS(1));
+}
+
+static int sim_inputs_init(void)
+{
+    int ret;
+
+    ret = adc_emul_value_func_set(sim_adc, DT_IO_CHANNELS_INPUT(SIM_SMOKE_NODE), sim_air_mv, NULL);
+    if (ret != 0) {
+        printk("sim: ADC input setup failed: %d\n", ret);
+        return ret;
+    }
+
+    k_work_init_delayable(&sim_flame_work, sim_flame_update);
+    k_work_schedule(&sim_flame_work, K_SECONDS(1));
+    return 0;
+}
+
+SYS_INIT(sim_inputs_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,71 @@
+#include "ts_codec.h"
+
+static const char b64url[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+size_t ts_codec_put_varint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+size_t ts_codec_put_entry(uint8_t *out, const struct ts_codec_entry *prev,
+                          const struct ts_codec_entry *cur)
+{
+    uint32_t dseq = (uint16_t)(cur->seq - prev->seq);
+    uint32_t dts = cur->ts - prev->ts;
+    uint32_t dval = ts_codec_zigzag(cur->value - prev->value);
+    size_t n;
+
+    if (out == NULL) {
+        return ts_codec_varint_len(dseq) + ts_codec_varint_len(dts) +
+               ts_codec_varint_len(dval);
+    }
+
+    n = ts_codec_put_varint(out, dseq);
+    n += ts_codec_put_varint(out + n, dts);
+    n += ts_codec_put_varint(out + n, dval);
+    return n;
+}
+
+size_t ts_codec_base64url(const uint8_t *in, size_t len, char *out, size_t out_size)
+{
+    size_t n = 0;
+    size_t i;
+
+    if (out_size < TS_CODEC_BASE64_LEN(len) + 1) {
+        return 0;
+    }
+
+    for (i = 0; i + 3 <= len; i += 3) {
+        uint32_t w = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+
+        out[n++] = b64url[(w >> 18) & 0x3f];
+        out[n++] = b64url[(w >> 12) & 0x3f];
+        out[n++] = b64url[(w >> 6) & 0x3f];
+        out[n++] = b64url[w & 0x3f];
+    }
+
+    /* 1 or 2 trailing bytes become 2 or 3 characters, no '=' padding */
+    if (i < len) {
+        uint32_t w = (uint32_t)in[i] << 16;
+
+        if (i + 1 < len) {
+            w |= (uint32_t)in[i + 1] << 8;
+        }
+        out[n++] = b64url[(w >> 18) & 0x3f];
+        out[n++] = b64url[(w >> 12) & 0x3f];
+        if (i + 1 < len) {
+            out[n++] = b64url[(w >> 6) & 0x3f];
+        }
+    }
+
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,64 @@
+#ifndef TS_CODEC_H_
+#define TS_CODEC_H_
+
+#include <stddef.h>
+#include <zephyr/types.h>
+
+/* Building blocks for the compact batch encoding: each reading is stored
+ * as deltas against the previous one, the signed value delta zig-zag
+ * mapped, every field as an LEB128 varint, and the byte string is carried
+ * in the query as unpadded base64url.
+ */
+
+/* Longest LEB128 encoding of a 32-bit value */
+#define TS_CODEC_VARINT_MAX 5
+
+/* Longest encoded entry: a 16-bit seq delta, then timestamp and value deltas */
+#define TS_CODEC_ENTRY_MAX (3 + 2 * TS_CODEC_VARINT_MAX)
+
+/* Characters needed for n bytes of unpadded base64url */
+#define TS_CODEC_BASE64_LEN(n) (((n) * 4 + 2) / 3)
+
+/* Bytes that hold the base64url text of len characters */
+#define TS_CODEC_BASE64_BYTES(len) (((len) * 3) / 4)
+
+static inline uint32_t ts_codec_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline size_t ts_codec_varint_len(uint32_t v)
+{
+    size_t n = 1;
+
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/* Append v as LEB128 at out (room for TS_CODEC_VARINT_MAX bytes); returns bytes written. */
+size_t ts_codec_put_varint(uint8_t *out, uint32_t v);
+
+/* The fields of one reading that go into a batch */
+struct ts_codec_entry {
+    uint32_t ts;            /* uptime, ms */
+    int32_t value;
+    uint16_t seq;
+};
+
+/* Append cur as varints of its deltas against prev (all zero for the first
+ * reading of a batch): seq (mod 2^16), timestamp (mod 2^32) and zig-zag
+ * value. With out NULL only the length is returned. Returns bytes written,
+ * at most TS_CODEC_ENTRY_MAX.
+ */
+size_t ts_codec_put_entry(uint8_t *out, const struct ts_codec_entry *prev,
+                          const struct ts_codec_entry *cur);
+
+/* Write len bytes as NUL-terminated unpadded base64url. Returns the number
+ * of characters written, or 0 if out_size is too small.
+ */
+size_t ts_codec_base64url(const uint8_t *in, size_t len, char *out, size_t out_size);
+
+#endif /* TS_CODEC_H_ */
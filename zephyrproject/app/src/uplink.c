@@ -0,0 +1,626 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <stdio.h>
+
+#include "esp_at.h"
+#include "esp_http.h"
+#include "ts_codec.h"
+#include "uplink.h"
+
+#define UPLINK_STACK_SIZE 1536        /* request buffers come from the esp_http pool */
+#define UPLINK_PRIORITY 6           /* below the sensor work queue (SENSOR_SCHED_PRIORITY) */
+#define UPLINK_WIFI_RETRY_S 30
+#define UPLINK_STATS_EVERY 10       /* print counters every N requests */
+
+/* === WiFi credentials === */
+#define WIFI_SSID "Swamp"
+#define WIFI_PASS "doodle123"
+
+/* === Server === */
+#define SERVER_HOST "10.181.159.160"
+#define SERVER_PORT 8080
+#define API_KEY "K72E1D4G1GFUC4VZ"
+
+/* Binary batch before base64url */
+#define UPLINK_BATCH_RAW_MAX TS_CODEC_BASE64_BYTES(UPLINK_BATCH_MAX_PAYLOAD)
+/* Every request ends with the same headers, fixed at compile time */
+#define UPLINK_REQ_TAIL ESP_HTTP_GET_TAIL(SERVER_HOST, SERVER_PORT)
+/* Pieces of the longest request, the summary: head, name, ten fields, tail */
+#define UPLINK_REQ_IOV_MAX 24
+/* Encoded fields of the largest request, the batch: send time and readings */
+BUILD_ASSERT(ESP_HTTP_INT_MAX + UPLINK_BATCH_MAX_PAYLOAD + 1 <= ESP_HTTP_REQ_MAX,
+             "batch fields do not fit a pool buffer");
+
+/* A request under construction. Literals and sensor table strings are
+ * referenced where they are; only numbers and the batch payload are
+ * encoded, one after another, into a pool buffer.
+ */
+struct uplink_req {
+    struct esp_uart_iov iov[UPLINK_REQ_IOV_MAX];
+    size_t cnt;
+    char *buf;
+    size_t used;
+};
+
+/* Summary queue entry */
+struct uplink_summary {
+    struct window_summary s;
+    uint8_t sensor;         /* sensor table id */
+};
+
+/* Readings of one sensor waiting to go out in a single request */
+struct uplink_batch {
+    struct uplink_sample samples[UPLINK_BATCH_MAX_SAMPLES];
+    uint16_t count;
+    uint16_t encoded_len;   /* bytes of the binary batch before base64url */
+};
+
+K_MSGQ_DEFINE(uplink_q, sizeof(struct uplink_sample), UPLINK_QUEUE_LEN, 4);
+K_MSGQ_DEFINE(alarm_q, sizeof(struct uplink_sample), UPLINK_ALARM_QUEUE_LEN, 4);
+K_MSGQ_DEFINE(summary_q, sizeof(struct uplink_summary), UPLINK_SUMMARY_QUEUE_LEN, 4);
+
+/* Raised whenever an alarm is queued; interrupts periodic uploads */
+static struct k_poll_signal alarm_signal = K_POLL_SIGNAL_INITIALIZER(alarm_signal);
+
+K_THREAD_STACK_DEFINE(uplink_stack, UPLINK_STACK_SIZE);
+static struct k_thread uplink_tid;
+
+/* Producer-side counters, updated from any sensor thread */
+static atomic_t seq[SENSOR_COUNT];
+static atomic_t submitted;
+static atomic_t overflows;
+static atomic_t queue_hwm;
+static atomic_t alarms;
+static atomic_t alarm_overflows;
+static atomic_t summary_overflows;
+
+/* Consumer-side state, only touched by the uplink thread */
+static struct uplink_batch batch[SENSOR_COUNT];
+static uint8_t batch_raw[UPLINK_BATCH_RAW_MAX];
+static uint32_t sent;
+static uint32_t failed;
+static uint32_t unconfirmed;
+static uint32_t requests;
+static uint32_t batches;
+static uint32_t batched;
+static uint32_t batch_bytes;
+static uint32_t summaries;
+static uint32_t summaries_unconfirmed;
+static uint32_t summary_failures;
+static uint32_t preemptions;
+static uint32_t alarm_retries;
+static uint32_t alarms_delivered;
+static uint32_t alarm_latency_last_ms;
+static uint32_t alarm_latency_max_ms;
+static uint64_t alarm_latency_sum_ms;
+
+static void update_hwm(uint32_t used)
+{
+    atomic_val_t hwm;
+
+    do {
+        hwm = atomic_get(&queue_hwm);
+        if ((atomic_val_t)used <= hwm) {
+            return;
+        }
+    } while (!atomic_cas(&queue_hwm, hwm, used));
+}
+
+void uplink_submit(int sensor, int32_t value)
+{
+    struct uplink_sample s = {
+        .timestamp_ms = k_uptime_get_32(),
+        .value = value,
+        .seq = (uint16_t)atomic_inc(&seq[sensor]),
+        .sensor = sensor,
+    };
+
+    atomic_inc(&submitted);
+
+    /* Keep the freshest data: make room by discarding the oldest entry */
+    while (k_msgq_put(&uplink_q, &s, K_NO_WAIT) != 0) {
+        struct uplink_sample oldest;
+
+        if (k_msgq_get(&uplink_q, &oldest, K_NO_WAIT) == 0) {
+            atomic_inc(&overflows);
+        }
+    }
+    update_hwm(k_msgq_num_used_get(&uplink_q));
+}
+
+void uplink_alarm(int sensor, int32_t value, uint32_t detected_ms)
+{
+    struct uplink_sample s = {
+        .timestamp_ms = detected_ms,
+        .value = value,
+        .seq = (uint16_t)atomic_inc(&seq[sensor]),
+        .sensor = sensor,
+        .flags = UPLINK_FLAG_ALARM,
+    };
+
+    atomic_inc(&alarms);
+    while (k_msgq_put(&alarm_q, &s, K_NO_WAIT) != 0) {
+        struct uplink_sample oldest;
+
+        if (k_msgq_get(&alarm_q, &oldest, K_NO_WAIT) == 0) {
+            atomic_inc(&alarm_overflows);
+        }
+    }
+    k_poll_signal_raise(&alarm_signal, 0);
+}
+
+void uplink_submit_summary(int sensor, const struct window_summary *summary)
+{
+    struct uplink_summary e = {
+        .s = *summary,
+        .sensor = sensor,
+    };
+
+    while (k_msgq_put(&summary_q, &e, K_NO_WAIT) != 0) {
+        struct uplink_summary oldest;
+
+        if (k_msgq_get(&summary_q, &oldest, K_NO_WAIT) == 0) {
+            atomic_inc(&summary_overflows);
+        }
+    }
+}
+
+/* Initialize/Connect ESP to your WiFi hotspot */
+static bool esp_wifi_connect(void)
+{
+    char buf[128];
+    int ret;
+
+    /* Reset module; it answers OK, reboots and prints "ready" */
+    esp_at_cmd("AT+CWQAP", K_SECONDS(2));
+    esp_at_send_cmd("AT+RST");
+    if (esp_at_wait(ESP_AT_EVT_READY, K_SECONDS(10)) < 0) {
+        printk("ESP did not report ready after reset\n");
+    }
+    /* the reset dropped any open TCP link */
+    esp_http_reset();
+
+    /* Set station mode */
+    ret = esp_at_cmd("AT+CWMODE=1", K_SECONDS(2));
+    if (ret) {
+        printk("AT+CWMODE failed: %d\n", ret);
+    }
+
+    /* Connect to WiFi: the firmware polls the join for up to ~15 s, then OK or FAIL */
+    snprintf(buf, sizeof(buf), "AT+CWJAP=\"%s\",\"%s\"", WIFI_SSID, WIFI_PASS);
+    ret = esp_at_cmd(buf, K_SECONDS(20));
+    if (ret) {
+        printk("ESP WiFi join failed: %d\n", ret);
+        return false;
+    }
+
+    /* optionally check IP */
+    esp_at_cmd("AT+CIFSR", K_SECONDS(2));
+
+    return true;
+}
+
+static int req_begin(struct uplink_req *r)
+{
+    r->cnt = 0;
+    r->used = 0;
+    r->buf = esp_http_buf_alloc(K_NO_WAIT);
+    if (r->buf == NULL) {
+        return -ENOMEM;
+    }
+    r->iov[r->cnt++] = ESP_UART_IOV_LIT(ESP_HTTP_GET_HEAD);
+    return 0;
+}
+
+static void req_add(struct uplink_req *r, const void *base, size_t len)
+{
+    r->iov[r->cnt++] = (struct esp_uart_iov){ .base = base, .len = len };
+}
+
+#define req_lit(r, s) req_add((r), (s), sizeof(s) - 1)
+
+static void req_u32(struct uplink_req *r, uint32_t v)
+{
+    size_t n = esp_http_put_u32(&r->buf[r->used], v);
+
+    req_add(r, &r->buf[r->used], n);
+    r->used += n;
+}
+
+static void req_i32(struct uplink_req *r, int32_t v)
+{
+    size_t n = esp_http_put_i32(&r->buf[r->used], v);
+
+    req_add(r, &r->buf[r->used], n);
+    r->used += n;
+}
+
+/* Send the request to the server and give its pool buffer back */
+static int req_send(struct uplink_req *r, struct k_poll_signal *abort)
+{
+    int ret;
+
+    r->iov[r->cnt++] = ESP_UART_IOV_LIT(UPLINK_REQ_TAIL);
+    ret = esp_http_request(SERVER_HOST, SERVER_PORT, r->iov, r->cnt, abort);
+
+    esp_http_buf_free(r->buf);
+    return ret;
+}
+
+/* GET <endpoint>?api_key=...&<param>=<value> */
+static int uplink_send(const struct uplink_sample *s, struct k_poll_signal *abort)
+{
+    const struct sensor_info *info = sensor_info_get(s->sensor);
+    struct uplink_req r;
+
+    if (req_begin(&r) != 0) {
+        return -ENOMEM;
+    }
+
+    req_add(&r, info->endpoint, info->endpoint_len);
+    req_lit(&r, "?api_key=" API_KEY "&");
+    req_add(&r, info->param, info->param_len);
+    req_lit(&r, "=");
+    req_i32(&r, s->value);
+
+    return req_send(&r, abort);
+}
+
+static void uplink_request_done(void)
+{
+    requests++;
+    if ((requests % UPLINK_STATS_EVERY) == 0) {
+        uplink_print_stats();
+        esp_http_print_stats();
+    }
+}
+
+/* Put a failed alarm back behind the other queued alarms; false once it has
+ * used up its retries. Never drops a newer alarm to make room.
+ */
+static bool alarm_retry(const struct uplink_sample *s)
+{
+    struct uplink_sample r = *s;
+    uint8_t tries = (s->flags & UPLINK_FLAG_TRIES_MASK) >> UPLINK_FLAG_TRIES_SHIFT;
+
+    if (tries >= UPLINK_ALARM_RETRIES) {
+        return false;
+    }
+    r.flags = (r.flags & ~UPLINK_FLAG_TRIES_MASK) | ((tries + 1) << UPLINK_FLAG_TRIES_SHIFT);
+    if (k_msgq_put(&alarm_q, &r, K_NO_WAIT) != 0) {
+        return false;
+    }
+    alarm_retries++;
+    return true;
+}
+
+static void uplink_account(const struct uplink_sample *s, int ret)
+{
+    uplink_request_done();
+    if (ret == ESP_HTTP_UNCONFIRMED) {
+        unconfirmed++;
+        return;
+    }
+    if (ret != 0) {
+        if ((s->flags & UPLINK_FLAG_ALARM) && alarm_retry(s)) {
+            printk("Upload of alarm from sensor %u seq %u failed, retrying\n",
+                   s->sensor, s->seq);
+            return;
+        }
+        failed++;
+        printk("Upload of sensor %u seq %u failed\n", s->sensor, s->seq);
+        return;
+    }
+
+    sent++;
+    if (s->flags & UPLINK_FLAG_ALARM) {
+        uint32_t latency = k_uptime_get_32() - s->timestamp_ms;
+
+        alarms_delivered++;
+        alarm_latency_last_ms = latency;
+        alarm_latency_max_ms = MAX(alarm_latency_max_ms, latency);
+        alarm_latency_sum_ms += latency;
+        printk("Alarm from sensor %u delivered in %u ms\n", s->sensor, latency);
+    }
+}
+
+/* The first reading of a batch is encoded against all zeros */
+static const struct uplink_sample batch_origin;
+
+/* One reading encoded against prev, see ts_codec_put_entry() */
+static size_t batch_entry(uint8_t *out, const struct uplink_sample *prev,
+                          const struct uplink_sample *s)
+{
+    const struct ts_codec_entry p = {
+        .ts = prev->timestamp_ms, .value = prev->value, .seq = prev->seq,
+    };
+    const struct ts_codec_entry c = {
+        .ts = s->timestamp_ms, .value = s->value, .seq = s->seq,
+    };
+
+    return ts_codec_put_entry(out, &p, &c);
+}
+
+static void batch_add(const struct uplink_sample *s)
+{
+    struct uplink_batch *b = &batch[s->sensor];
+    const struct uplink_sample *prev = b->count ? &b->samples[b->count - 1] : &batch_origin;
+
+    b->encoded_len += batch_entry(NULL, prev, s);
+    b->samples[b->count++] = *s;
+}
+
+static bool batch_due(const struct uplink_batch *b, uint32_t now)
+{
+    if (b->count == 0) {
+        return false;
+    }
+
+    return b->count >= UPLINK_BATCH_MAX_SAMPLES ||
+           TS_CODEC_BASE64_LEN(b->encoded_len + TS_CODEC_ENTRY_MAX) >
+               UPLINK_BATCH_MAX_PAYLOAD ||
+           now - b->samples[0].timestamp_ms >= UPLINK_BATCH_MAX_AGE_MS;
+}
+
+/* First sensor whose batch has to go out now, or -1 */
+static int batch_next_due(uint32_t now)
+{
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        if (batch_due(&batch[i], now)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Milliseconds until the oldest buffered reading reaches its age limit, or -1 if none */
+static int32_t batch_due_in_ms(uint32_t now)
+{
+    int32_t wait = -1;
+
+    for (int i = 0; i < SENSOR_COUNT; i++) {
+        const struct uplink_batch *b = &batch[i];
+        int32_t left;
+
+        if (b->count == 0) {
+            continue;
+        }
+        left = (int32_t)(UPLINK_BATCH_MAX_AGE_MS - (now - b->samples[0].timestamp_ms));
+        left = MAX(left, 0);
+        if (wait < 0 || left < wait) {
+            wait = left;
+        }
+    }
+    return wait;
+}
+
+/* GET /api/batch.php?...&sensor=<name>&now=<uptime>&z=<base64url of batch_entry()s>
+ * "now" lets the server turn the node's uptime stamps into wall-clock time.
+ */
+static int batch_send(int sensor, struct k_poll_signal *abort)
+{
+    const struct uplink_batch *b = &batch[sensor];
+    const struct sensor_info *info = sensor_info_get(sensor);
+    struct uplink_req r;
+    size_t raw = 0;
+    size_t len;
+
+    if (req_begin(&r) != 0) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < b->count; i++) {
+        raw += batch_entry(&batch_raw[raw], i ? &b->samples[i - 1] : &batch_origin,
+                           &b->samples[i]);
+    }
+
+    req_lit(&r, "/iot_monitor/api/batch.php?api_key=" API_KEY "&sensor=");
+    req_add(&r, info->name, info->name_len);
+    req_lit(&r, "&now=");
+    req_u32(&r, k_uptime_get_32());
+    req_lit(&r, "&z=");
+
+    len = ts_codec_base64url(batch_raw, raw, &r.buf[r.used], ESP_HTTP_REQ_MAX - r.used);
+    if (len == 0) {
+        esp_http_buf_free(r.buf);
+        return -ENOSPC;
+    }
+    req_add(&r, &r.buf[r.used], len);
+    r.used += len + 1;
+    batch_bytes += len;
+
+    return req_send(&r, abort);
+}
+
+static void batch_account(int sensor, int ret)
+{
+    struct uplink_batch *b = &batch[sensor];
+
+    batches++;
+    batched += b->count;
+    uplink_request_done();
+    if (ret == ESP_HTTP_UNCONFIRMED) {
+        unconfirmed += b->count;
+    } else if (ret != 0) {
+        failed += b->count;
+        printk("Upload of %u %s samples (seq %u..%u) failed\n",
+               b->count, sensor_info_get(sensor)->name,
+               b->samples[0].seq, b->samples[b->count - 1].seq);
+    } else {
+        sent += b->count;
+    }
+    b->count = 0;
+    b->encoded_len = 0;
+}
+
+/* GET /api/summary.php?...&sensor=<name>&now=<uptime>&t=<window end>&n=...&p99=... */
+static int summary_send(const struct uplink_summary *e, struct k_poll_signal *abort)
+{
+    const struct window_summary *w = &e->s;
+    const struct sensor_info *info = sensor_info_get(e->sensor);
+    struct uplink_req r;
+
+    if (req_begin(&r) != 0) {
+        return -ENOMEM;
+    }
+
+    req_lit(&r, "/iot_monitor/api/summary.php?api_key=" API_KEY "&sensor=");
+    req_add(&r, info->name, info->name_len);
+    req_lit(&r, "&now=");
+    req_u32(&r, k_uptime_get_32());
+    req_lit(&r, "&t=");
+    req_u32(&r, w->end_ms);
+    req_lit(&r, "&n=");
+    req_u32(&r, w->count);
+    req_lit(&r, "&min=");
+    req_i32(&r, w->min);
+    req_lit(&r, "&max=");
+    req_i32(&r, w->max);
+    req_lit(&r, "&mean=");
+    req_i32(&r, w->mean);
+    req_lit(&r, "&var=");
+    req_u32(&r, w->variance);
+    req_lit(&r, "&p50=");
+    req_i32(&r, w->p50);
+    req_lit(&r, "&p95=");
+    req_i32(&r, w->p95);
+    req_lit(&r, "&p99=");
+    req_i32(&r, w->p99);
+
+    return req_send(&r, abort);
+}
+
+static void uplink_thread(void *arg1, void *arg2, void *arg3)
+{
+    struct k_poll_event events[] = {
+        K_POLL_EVENT_STATIC_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                                        K_POLL_MODE_NOTIFY_ONLY, &alarm_q, 0),
+        K_POLL_EVENT_STATIC_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                                        K_POLL_MODE_NOTIFY_ONLY, &uplink_q, 0),
+        K_POLL_EVENT_STATIC_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                                        K_POLL_MODE_NOTIFY_ONLY, &summary_q, 0),
+    };
+    struct uplink_summary e;
+    struct uplink_sample s;
+    uint32_t now;
+    int32_t wait_ms;
+    int sensor;
+    int ret;
+
+    printk("Initializing ESP and connecting to WiFi...\n");
+    while (!esp_wifi_connect()) {
+        printk("Failed to connect ESP to WiFi. Check credentials and wiring.\n");
+        k_sleep(K_SECONDS(UPLINK_WIFI_RETRY_S));
+    }
+
+    while (1) {
+        /* Reset before draining so an alarm queued meanwhile re-raises it */
+        k_poll_signal_reset(&alarm_signal);
+
+        if (k_msgq_get(&alarm_q, &s, K_NO_WAIT) == 0) {
+            uplink_account(&s, uplink_send(&s, NULL));
+            continue;
+        }
+
+        /* Peek, so that a preempted summary stays queued */
+        if (k_msgq_peek(&summary_q, &e) == 0) {
+            ret = summary_send(&e, &alarm_signal);
+            if (ret == -ECANCELED) {
+                preemptions++;
+                continue;
+            }
+            k_msgq_get(&summary_q, &e, K_NO_WAIT);
+            uplink_request_done();
+            if (ret == ESP_HTTP_UNCONFIRMED) {
+                summaries_unconfirmed++;
+            } else if (ret != 0) {
+                summary_failures++;
+                printk("Upload of %s summary failed\n", sensor_info_get(e.sensor)->name);
+            } else {
+                summaries++;
+            }
+            continue;
+        }
+
+        now = k_uptime_get_32();
+        sensor = batch_next_due(now);
+        if (sensor >= 0) {
+            ret = batch_send(sensor, &alarm_signal);
+            if (ret == -ECANCELED) {
+                /* Nothing went out: the batch is kept and retried after the alarms */
+                preemptions++;
+                continue;
+            }
+            batch_account(sensor, ret);
+            continue;
+        }
+
+        /* A full batch was flushed above, so there is room for this sample */
+        if (k_msgq_get(&uplink_q, &s, K_NO_WAIT) == 0) {
+            batch_add(&s);
+            continue;
+        }
+
+        /* Sleep until something is queued or the oldest reading ages out */
+        wait_ms = batch_due_in_ms(now);
+        for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+            events[i].state = K_POLL_STATE_NOT_READY;
+        }
+        k_poll(events, ARRAY_SIZE(events), wait_ms < 0 ? K_FOREVER : K_MSEC(wait_ms));
+    }
+}
+
+void uplink_start(void)
+{
+    k_thread_create(&uplink_tid, uplink_stack, K_THREAD_STACK_SIZEOF(uplink_stack),
+                    uplink_thread, NULL, NULL, NULL,
+                    UPLINK_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&uplink_tid, "uplink");
+}
+
+void uplink_get_stats(struct uplink_stats *out)
+{
+    out->submitted = (uint32_t)atomic_get(&submitted);
+    out->overflows = (uint32_t)atomic_get(&overflows);
+    out->sent = sent;
+    out->failed = failed;
+    out->unconfirmed = unconfirmed;
+    out->batches = batches;
+    out->batched = batched;
+    out->batch_bytes = batch_bytes;
+    out->summaries = summaries;
+    out->summaries_unconfirmed = summaries_unconfirmed;
+    out->summary_failures = summary_failures;
+    out->summary_overflows = (uint32_t)atomic_get(&summary_overflows);
+    out->queue_hwm = (uint32_t)atomic_get(&queue_hwm);
+    out->alarms = (uint32_t)atomic_get(&alarms);
+    out->alarm_overflows = (uint32_t)atomic_get(&alarm_overflows);
+    out->alarm_retries = alarm_retries;
+    out->preemptions = preemptions;
+    out->alarm_latency_last_ms = alarm_latency_last_ms;
+    out->alarm_latency_max_ms = alarm_latency_max_ms;
+    out->alarm_latency_avg_ms = alarms_delivered ?
+                                (uint32_t)(alarm_latency_sum_ms / alarms_delivered) : 0;
+}
+
+void uplink_print_stats(void)
+{
+    struct uplink_stats st;
+
+    uplink_get_stats(&st);
+    printk("Uplink: queued %u/%u (hwm %u), submitted %u, overflows %u, sent %u, "
+           "unconfirmed %u, failed %u\n",
+           k_msgq_num_used_get(&uplink_q), UPLINK_QUEUE_LEN, st.queue_hwm,
+           st.submitted, st.overflows, st.sent, st.unconfirmed, st.failed);
+    printk("Uplink: %u batch requests, %u samples/request, %u bytes/sample, "
+           "%u summaries (%u unconfirmed, failed %u, overflows %u)\n",
+           st.batches, st.batches ? st.batched / st.batches : 0,
+           st.batched ? st.batch_bytes / st.batched : 0,
+           st.summaries, st.summaries_unconfirmed, st.summary_failures,
+           st.summary_overflows);
+    printk("Uplink: alarms %u (overflows %u, retries %u), preemptions %u, "
+           "alarm latency last %u max %u avg %u ms\n",
+           st.alarms, st.alarm_overflows, st.alarm_retries, st.preemptions,
+           st.alarm_latency_last_ms, st.alarm_latency_max_ms, st.alarm_latency_avg_ms);
+}
@@ -0,0 +1,88 @@
+#ifndef UPLINK_H_
+#define UPLINK_H_
+
+#include <zephyr/sys/util.h>
+#include <zephyr/types.h>
+
+#include "sensor_table.h"
+#include "window_stats.h"
+
+/* Depth of the sample queue between sensor threads and the uplink thread */
+#define UPLINK_QUEUE_LEN 16
+/* Alarms get their own, short queue that is always drained first */
+#define UPLINK_ALARM_QUEUE_LEN 4
+/* A failed alarm upload goes back to the end of the alarm queue this many times */
+#define UPLINK_ALARM_RETRIES 3
+
+/* Periodic samples are batched per sensor and uploaded together once any
+ * of these limits is reached. Alarms are never batched.
+ */
+#define UPLINK_BATCH_MAX_SAMPLES  12      /* N: readings per request */
+#define UPLINK_BATCH_MAX_AGE_MS   60000   /* T: oldest reading waits at most this long */
+#define UPLINK_BATCH_MAX_PAYLOAD  320     /* base64url characters of readings per request */
+
+/* Window summaries waiting for upload; one per window, so this is plenty */
+#define UPLINK_SUMMARY_QUEUE_LEN 2
+
+/* Fixed-size record handed from a sensor to the uplink thread */
+struct uplink_sample {
+    uint32_t timestamp_ms;  /* k_uptime_get_32() when sampled */
+    int32_t value;
+    uint16_t seq;           /* per-sensor sequence number, set by uplink_submit() */
+    uint8_t sensor;         /* sensor table id */
+    uint8_t flags;          /* UPLINK_FLAG_* */
+};
+
+#define UPLINK_FLAG_ALARM BIT(0)
+/* Failed upload attempts of an alarm so far, bits 1-2 */
+#define UPLINK_FLAG_TRIES_SHIFT 1
+#define UPLINK_FLAG_TRIES_MASK  (BIT_MASK(2) << UPLINK_FLAG_TRIES_SHIFT)
+BUILD_ASSERT(UPLINK_ALARM_RETRIES <= BIT_MASK(2), "retry count does not fit the flags");
+
+struct uplink_stats {
+    uint32_t submitted;
+    uint32_t overflows;     /* oldest queued sample dropped to make room */
+    uint32_t sent;          /* samples acknowledged by the server */
+    uint32_t failed;        /* samples whose upload was not acknowledged */
+    uint32_t unconfirmed;   /* samples delivered, response cut short by an alarm */
+    uint32_t batches;       /* requests that carried periodic samples */
+    uint32_t batched;       /* samples carried by those requests */
+    uint32_t batch_bytes;   /* encoded payload characters of those requests */
+    uint32_t summaries;     /* window summaries acknowledged by the server */
+    uint32_t summaries_unconfirmed; /* delivered, response cut short by an alarm */
+    uint32_t summary_failures;  /* summaries dropped after a failed upload */
+    uint32_t summary_overflows;
+    uint32_t queue_hwm;     /* deepest the queue has been */
+    uint32_t alarms;
+    uint32_t alarm_overflows;
+    uint32_t alarm_retries; /* failed alarm uploads queued again */
+    uint32_t preemptions;   /* periodic uploads cut short by an alarm */
+    uint32_t alarm_latency_last_ms; /* detection -> server response */
+    uint32_t alarm_latency_max_ms;
+    uint32_t alarm_latency_avg_ms;
+};
+
+/* Start the thread that owns the ESP link: joins WiFi, then drains the queues. */
+void uplink_start(void);
+
+/* Queue a sample for upload. Never blocks: if the queue is full the oldest
+ * entry is discarded and counted as an overflow.
+ */
+void uplink_submit(int sensor, int32_t value);
+
+/* Queue an alarm. It is sent before any queued periodic sample and cuts
+ * short a periodic upload that is still waiting to connect or for its
+ * response. detected_ms is the k_uptime_get_32() timestamp of the event
+ * and is used for the end-to-end latency metric.
+ */
+void uplink_alarm(int sensor, int32_t value, uint32_t detected_ms);
+
+/* Queue the summary of a closed window. Never blocks; if the queue is full
+ * the oldest summary is discarded.
+ */
+void uplink_submit_summary(int sensor, const struct window_summary *summary);
+
+void uplink_get_stats(struct uplink_stats *out);
+void uplink_print_stats(void);
+
+#endif /* UPLINK_H_ */
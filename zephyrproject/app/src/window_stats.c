@@ -0,0 +1,109 @@
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "window_stats.h"
+
+void window_stats_init(struct window_stats *ws, uint32_t range)
+{
+    ws->bin_width = MAX(DIV_ROUND_UP(range, WINDOW_STATS_BINS), 1);
+    window_stats_reset(ws);
+}
+
+void window_stats_reset(struct window_stats *ws)
+{
+    uint32_t bin_width = ws->bin_width;
+
+    memset(ws, 0, sizeof(*ws));
+    ws->bin_width = bin_width;
+    ws->min = INT32_MAX;
+    ws->max = INT32_MIN;
+}
+
+static inline uint32_t bin_of(int32_t value, uint32_t bin_width)
+{
+    return MIN((uint32_t)MAX(value, 0) / bin_width, WINDOW_STATS_BINS - 1);
+}
+
+void window_stats_add(struct window_stats *ws, int32_t value)
+{
+    uint32_t bin = bin_of(value, ws->bin_width);
+
+    ws->count++;
+    ws->min = MIN(ws->min, value);
+    ws->max = MAX(ws->max, value);
+    ws->sum += value;
+    ws->sum_sq += (uint64_t)((int64_t)value * value);
+    if (ws->hist[bin] < UINT16_MAX) {
+        ws->hist[bin]++;
+    }
+}
+
+void window_stats_add_block(struct window_stats *ws, const int16_t *samples, size_t n,
+                            size_t stride)
+{
+    uint32_t bin_width = ws->bin_width;
+    int32_t min = ws->min;
+    int32_t max = ws->max;
+    int32_t sum = 0;        /* blocks are a half-buffer of 16-bit samples: no overflow */
+    uint64_t sum_sq = 0;
+
+    for (size_t i = 0; i < n; i++, samples += stride) {
+        int32_t value = *samples;
+        uint32_t bin = bin_of(value, bin_width);
+
+        min = MIN(min, value);
+        max = MAX(max, value);
+        sum += value;
+        sum_sq += (uint32_t)(value * value);
+        if (ws->hist[bin] < UINT16_MAX) {
+            ws->hist[bin]++;
+        }
+    }
+
+    ws->count += n;
+    ws->min = min;
+    ws->max = max;
+    ws->sum += sum;
+    ws->sum_sq += sum_sq;
+}
+
+/* Value below which pct percent of the window lies, interpolated inside its bin */
+static int32_t percentile(const struct window_stats *ws, uint32_t pct)
+{
+    uint32_t rank = DIV_ROUND_UP(ws->count * pct, 100);
+    uint32_t seen = 0;
+
+    for (int b = 0; b < WINDOW_STATS_BINS; b++) {
+        uint32_t n = ws->hist[b];
+
+        if (n != 0 && seen + n >= rank) {
+            int32_t v = (int32_t)(b * ws->bin_width + ((rank - seen) * ws->bin_width) / n);
+
+            return CLAMP(v, ws->min, ws->max);
+        }
+        seen += n;
+    }
+    return ws->max;
+}
+
+void window_stats_summarize(struct window_stats *ws, uint32_t now_ms, struct window_summary *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->end_ms = now_ms;
+    out->count = ws->count;
+
+    if (ws->count != 0) {
+        int64_t n = ws->count;
+
+        out->min = ws->min;
+        out->max = ws->max;
+        out->mean = (int32_t)(ws->sum / n);
+        /* n*sum(x^2) - sum(x)^2 fits in 64 bits for 16-bit samples and counts */
+        out->variance = (uint32_t)((n * (int64_t)ws->sum_sq - ws->sum * ws->sum) / (n * n));
+        out->p50 = percentile(ws, 50);
+        out->p95 = percentile(ws, 95);
+        out->p99 = percentile(ws, 99);
+    }
+
+    window_stats_reset(ws);
+}
@@ -0,0 +1,59 @@
+#ifndef WINDOW_STATS_H_
+#define WINDOW_STATS_H_
+
+#include <stddef.h>
+#include <zephyr/types.h>
+
+/* Fixed-bin histogram used for the percentiles, spread over the range of
+ * the sensor's units (ADC counts, ppm, ...) given to window_stats_init():
+ * p50/p95/p99 are exact to within one of the 64 bins.
+ */
+#define WINDOW_STATS_BINS  64
+
+/* A window may hold at most this many samples (bin counters are 16 bit) */
+#define WINDOW_STATS_MAX_COUNT UINT16_MAX
+
+/* Running statistics of one window; O(1) memory whatever its length */
+struct window_stats {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint64_t sum_sq;
+    uint32_t bin_width;     /* set by window_stats_init(), kept across windows */
+    uint16_t hist[WINDOW_STATS_BINS];
+};
+
+/* Integer summary of a closed window, as uploaded */
+struct window_summary {
+    uint32_t end_ms;        /* k_uptime_get_32() when the window closed */
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    uint32_t variance;      /* population variance, in the sensor's units squared */
+    int32_t p50;
+    int32_t p95;
+    int32_t p99;
+};
+
+/* Start the first window for values in 0..range-1 */
+void window_stats_init(struct window_stats *ws, uint32_t range);
+
+/* Discard the current window; the range stays. */
+void window_stats_reset(struct window_stats *ws);
+
+/* Add one sample; values outside the range land in the edge bins. */
+void window_stats_add(struct window_stats *ws, int32_t value);
+
+/* Add n samples taken stride apart, e.g. one channel of an interleaved
+ * scan buffer. Same result as n window_stats_add() calls, with the running
+ * sums kept in registers for the whole block.
+ */
+void window_stats_add_block(struct window_stats *ws, const int16_t *samples, size_t n,
+                            size_t stride);
+
+/* Close the window into out and start a new one. */
+void window_stats_summarize(struct window_stats *ws, uint32_t now_ms, struct window_summary *out);
+
+#endif /* WINDOW_STATS_H_ */
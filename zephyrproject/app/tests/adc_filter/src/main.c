@@ -0,0 +1,116 @@
+#include <zephyr/ztest.h>
+
+#include "adc_filter.h"
+#include "bench.h"
+
+#define BENCH_READINGS 20000
+
+static int32_t feed(struct adc_filter *f, int16_t a, int16_t b, int16_t c, int16_t d, int16_t e)
+{
+    int16_t burst[ADC_FILTER_BURST] = { a, b, c, d, e };
+
+    return adc_filter_update(f, burst, ADC_FILTER_BURST);
+}
+
+ZTEST(adc_filter, test_first_reading_primes)
+{
+    struct adc_filter f = ADC_FILTER_INIT(3);
+
+    zassert_equal(feed(&f, 1200, 1210, 1190, 1205, 1195), 1200);
+    zassert_true(f.primed);
+    zassert_equal(f.readings, 1);
+}
+
+ZTEST(adc_filter, test_median_rejects_spikes)
+{
+    struct adc_filter f = ADC_FILTER_INIT(0);   /* no smoothing: the median alone */
+
+    zassert_equal(feed(&f, 500, 4095, 500, 500, 0), 500);
+    zassert_equal(feed(&f, 4095, 800, 4095, 800, 800), 800);
+    zassert_equal(feed(&f, 10, 20, 30, 40, 50), 30);
+}
+
+ZTEST(adc_filter, test_ema_step_response)
+{
+    struct adc_filter f = ADC_FILTER_INIT(2);
+    int32_t prev = 0;
+    int32_t v = 0;
+
+    feed(&f, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 40; i++) {
+        v = feed(&f, 1000, 1000, 1000, 1000, 1000);
+        zassert_true(v >= prev && v <= 1000, "reading %d: %d after %d", i, v, prev);
+        prev = v;
+    }
+    zassert_equal(v, 1000, "EMA settled at %d", v);
+
+    /* the way down uses an arithmetic shift and must not stick above 0 */
+    for (int i = 0; i < 40; i++) {
+        v = feed(&f, 0, 0, 0, 0, 0);
+    }
+    zassert_equal(v, 0, "EMA settled at %d", v);
+}
+
+ZTEST(adc_filter, test_negative_values)
+{
+    struct adc_filter f = ADC_FILTER_INIT(1);
+
+    zassert_equal(feed(&f, -100, -100, -100, -100, -100), -100);
+    for (int i = 0; i < 30; i++) {
+        feed(&f, -300, -300, -300, -300, -300);
+    }
+    zassert_equal(feed(&f, -300, -300, -300, -300, -300), -300);
+}
+
+ZTEST(adc_filter, test_block_matches_bursts)
+{
+    /* two interleaved channels, 3 bursts each plus a partial one */
+    int16_t scan[2 * (3 * ADC_FILTER_BURST + 2)];
+    struct adc_filter by_block = ADC_FILTER_INIT(2);
+    struct adc_filter by_burst = ADC_FILTER_INIT(2);
+    int16_t burst[ADC_FILTER_BURST];
+    int32_t expect = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(scan) / 2; i++) {
+        scan[2 * i] = (int16_t)(i * 37 % 101);
+        scan[2 * i + 1] = (int16_t)(2000 + (i * 53 % 97));
+    }
+    for (size_t i = 0; i + ADC_FILTER_BURST <= ARRAY_SIZE(scan) / 2; i += ADC_FILTER_BURST) {
+        for (size_t j = 0; j < ADC_FILTER_BURST; j++) {
+            burst[j] = scan[2 * (i + j) + 1];
+        }
+        expect = adc_filter_update(&by_burst, burst, ADC_FILTER_BURST);
+    }
+
+    zassert_equal(adc_filter_update_block(&by_block, &scan[1], ARRAY_SIZE(scan) / 2, 2), expect);
+    zassert_equal(by_block.readings, 3);
+    zassert_equal(by_block.ema_q8, by_burst.ema_q8);
+}
+
+/* Cost of one filtered reading: a burst sorted for its median, one EMA step */
+ZTEST(adc_filter, test_bench_update)
+{
+    struct adc_filter f = ADC_FILTER_INIT(3);
+    int16_t burst[ADC_FILTER_BURST];
+    uint32_t lfsr = 0xACE1u;
+    volatile int32_t sink = 0;
+    uint64_t start;
+    uint64_t ns;
+
+    start = bench_start();
+    for (int i = 0; i < BENCH_READINGS; i++) {
+        /* noisy level around 1500 counts; the sort sees a new order each time */
+        for (int j = 0; j < ADC_FILTER_BURST; j++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+            burst[j] = (int16_t)(1500 + (lfsr & 0x3f));
+        }
+        sink += adc_filter_update(&f, burst, ADC_FILTER_BURST);
+    }
+    ns = bench_ns(start);
+
+    zassert_equal(f.readings, BENCH_READINGS);
+    bench_report("adc_filter_update (burst of " STRINGIFY(ADC_FILTER_BURST) ")",
+                 ns, BENCH_READINGS);
+}
+
+ZTEST_SUITE(adc_filter, NULL, NULL, NULL, NULL, NULL);
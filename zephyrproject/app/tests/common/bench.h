@@ -0,0 +1,51 @@
+#ifndef TEST_BENCH_H_
+#define TEST_BENCH_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/time_units.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <time.h>
+#endif
+
+/* Timing for the benchmark cases. On hardware this is the CPU cycle
+ * counter. native_sim's kernel clock is simulated and stands still while
+ * code runs, so there the host's monotonic clock is read instead (the test
+ * builds against the host libc for it, see boards/native_sim.conf).
+ */
+static inline uint64_t bench_start(void)
+{
+#if defined(CONFIG_ARCH_POSIX)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+/* Nanoseconds since bench_start() returned start */
+static inline uint64_t bench_ns(uint64_t start)
+{
+#if defined(CONFIG_ARCH_POSIX)
+    return bench_start() - start;
+#else
+    return k_cyc_to_ns_floor64(k_cycle_get_32() - (uint32_t)start);
+#endif
+}
+
+/* Report ns per operation, and CPU cycles per operation on hardware */
+static inline void bench_report(const char *what, uint64_t ns, uint32_t ops)
+{
+    uint64_t ps_per_op = ns * 1000U / ops;
+
+    TC_PRINT("%s: %u ops, %u.%03u ns/op", what, ops,
+             (uint32_t)(ps_per_op / 1000U), (uint32_t)(ps_per_op % 1000U));
+#if !defined(CONFIG_ARCH_POSIX)
+    TC_PRINT(", %u cycles/op", (uint32_t)k_ns_to_cyc_floor64(ns / ops));
+#endif
+    TC_PRINT("\n");
+}
+
+#endif /* TEST_BENCH_H_ */
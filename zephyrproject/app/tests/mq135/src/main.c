@@ -0,0 +1,134 @@
+#include <zephyr/ztest.h>
+#include <math.h>
+
+#include "mq135.h"
+
+#define Q16_ONE 65536
+
+/* scripts/gen_mq135_lut.py defaults: CO2, Rs/R0 from 0.25 to 4 in 65 points */
+#define CURVE_A 116.6020682
+#define CURVE_B -2.769034857
+#define RATIO_MIN (BIT(MQ135_RATIO_SHIFT) / 4)
+#define RATIO_MAX (BIT(MQ135_RATIO_SHIFT) * 4)
+#define LUT_POINTS 65
+
+static const struct device *const gas = DEVICE_DT_GET(DT_NODELABEL(mq135));
+
+/* The datasheet power law at a Q10 ratio */
+static double curve_ppm(uint32_t ratio)
+{
+    return CURVE_A * pow((double)ratio / BIT(MQ135_RATIO_SHIFT), CURVE_B);
+}
+
+static double table_ppm(uint32_t ratio)
+{
+    return (double)mq135_ratio_to_ppm_q4(ratio) / BIT(MQ135_PPM_SHIFT);
+}
+
+/* Within 2 % of the curve; below 20 ppm the Q4 step dominates */
+static bool close_to_curve(uint32_t ratio)
+{
+    double want = curve_ppm(ratio);
+    double got = table_ppm(ratio);
+
+    return want >= 20.0 ? fabs(got - want) <= want * 0.02 : fabs(got - want) <= 0.25;
+}
+
+/* Rs is referred to 20 C: the reference temperature must be a factor of exactly 1 */
+ZTEST(mq135, test_temp_reference_is_one)
+{
+    zassert_equal(mq135_temp_q16(20), Q16_ONE, "f(20) = %u", mq135_temp_q16(20));
+}
+
+/* Against the fitted curve divided by its value at 20 C, evaluated in double */
+ZTEST(mq135, test_temp_curve)
+{
+    zassert_within(mq135_temp_q16(-10), 112479, 1);
+    zassert_within(mq135_temp_q16(0), 92206, 1);
+    zassert_within(mq135_temp_q16(35), 57676, 1);
+    zassert_within(mq135_temp_q16(50), 60223, 1);
+
+    /* colder air reads a higher Rs, up to the curve's minimum near 39 C */
+    for (int32_t t = -10; t < 38; t++) {
+        zassert_true(mq135_temp_q16(t) > mq135_temp_q16(t + 1), "at %d C", t);
+    }
+}
+
+ZTEST(mq135, test_temp_clamps)
+{
+    zassert_equal(mq135_temp_q16(-40), mq135_temp_q16(-10));
+    zassert_equal(mq135_temp_q16(85), mq135_temp_q16(50));
+}
+
+/* The table points, as the generator spaces them, and halfway between them */
+ZTEST(mq135, test_lut_points_and_midpoints)
+{
+    double step = pow((double)RATIO_MAX / RATIO_MIN, 1.0 / (LUT_POINTS - 1));
+
+    for (int i = 0; i < LUT_POINTS; i++) {
+        uint32_t point = (uint32_t)lround(RATIO_MIN * pow(step, i));
+        uint32_t mid = (uint32_t)lround(RATIO_MIN * pow(step, i + 0.5));
+
+        zassert_true(close_to_curve(point), "point %d: ratio %u, %d.%02d ppm", i, point,
+                     (int)table_ppm(point), (int)(table_ppm(point) * 100) % 100);
+        if (i < LUT_POINTS - 1) {
+            zassert_true(close_to_curve(mid), "after point %d: ratio %u", i, mid);
+        }
+    }
+
+    /* clean air, Rs = R0 */
+    zassert_within(mq135_ratio_to_ppm_q4(BIT(MQ135_RATIO_SHIFT)) >> MQ135_PPM_SHIFT, 117, 2);
+}
+
+ZTEST(mq135, test_lut_every_ratio)
+{
+    for (uint32_t r = RATIO_MIN; r <= RATIO_MAX; r++) {
+        zassert_true(close_to_curve(r), "ratio %u", r);
+    }
+}
+
+ZTEST(mq135, test_lut_clamps)
+{
+    uint32_t top = mq135_ratio_to_ppm_q4(RATIO_MIN);
+    uint32_t bottom = mq135_ratio_to_ppm_q4(RATIO_MAX);
+
+    zassert_equal(mq135_ratio_to_ppm_q4(0), top);
+    zassert_equal(mq135_ratio_to_ppm_q4(RATIO_MIN - 1), top);
+    zassert_equal(mq135_ratio_to_ppm_q4(RATIO_MAX + 1), bottom);
+    zassert_equal(mq135_ratio_to_ppm_q4(UINT32_MAX), bottom);
+
+    zassert_equal(mq135_ppm_max(gas), DIV_ROUND_UP(top, BIT(MQ135_PPM_SHIFT)));
+    zassert_within(mq135_ppm_max(gas), (int32_t)curve_ppm(RATIO_MIN), 55);
+}
+
+/* A dirtier sensor (lower Rs/R0) never reads less */
+ZTEST(mq135, test_lut_monotonic)
+{
+    uint32_t prev = mq135_ratio_to_ppm_q4(0);
+
+    for (uint32_t r = 1; r <= RATIO_MAX + 16; r++) {
+        uint32_t ppm = mq135_ratio_to_ppm_q4(r);
+
+        zassert_true(ppm <= prev, "ratio %u: %u after %u", r, ppm, prev);
+        prev = ppm;
+    }
+}
+
+/* Through the driver: more counts is a lower Rs, so more ppm */
+ZTEST(mq135, test_counts_to_ppm)
+{
+    int32_t prev = 0;
+
+    zassert_true(device_is_ready(gas));
+    for (int32_t c = -1; c <= 4096; c++) {
+        int32_t ppm = mq135_counts_to_ppm(gas, c);
+
+        zassert_true(ppm >= prev && ppm <= mq135_ppm_max(gas), "%d counts: %d ppm", c, ppm);
+        prev = ppm;
+    }
+
+    /* Rs/R0 = 2047/2048, just off clean air */
+    zassert_within(mq135_counts_to_ppm(gas, 2048), (int32_t)lround(curve_ppm(1023)), 2);
+}
+
+ZTEST_SUITE(mq135, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,214 @@
+#include <zephyr/ztest.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ts_codec.h"
+#include "bench.h"
+
+#define BATCH_LEN     12      /* UPLINK_BATCH_MAX_SAMPLES */
+#define BENCH_BATCHES 2000
+
+/* A batch as uplink.c batch_send() encodes it */
+static size_t encode_batch(const struct ts_codec_entry *r, size_t n, uint8_t *out)
+{
+    static const struct ts_codec_entry origin;
+    size_t len = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        len += ts_codec_put_entry(&out[len], i ? &r[i - 1] : &origin, &r[i]);
+    }
+    return len;
+}
+
+/* The decoders, as in python_handler.py */
+static size_t get_varint(const uint8_t *in, uint32_t *v)
+{
+    size_t n = 0;
+
+    *v = 0;
+    do {
+        *v |= (uint32_t)(in[n] & 0x7f) << (7 * n);
+    } while (in[n++] & 0x80);
+    return n;
+}
+
+static size_t decode_batch(const uint8_t *in, size_t len, struct ts_codec_entry *r)
+{
+    struct ts_codec_entry prev = { 0 };
+    size_t n = 0;
+    uint32_t v;
+
+    for (size_t i = 0; i < len; n++) {
+        i += get_varint(&in[i], &v);
+        r[n].seq = (uint16_t)(prev.seq + v);
+        i += get_varint(&in[i], &v);
+        r[n].ts = prev.ts + v;
+        i += get_varint(&in[i], &v);
+        r[n].value = prev.value + (int32_t)((v >> 1) ^ -(v & 1));
+        prev = r[n];
+    }
+    return n;
+}
+
+static size_t base64url_decode(const char *in, uint8_t *out)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    uint32_t w = 0;
+    int bits = 0;
+    size_t n = 0;
+
+    for (; *in != '\0'; in++) {
+        w = (w << 6) | (uint32_t)(strchr(alphabet, *in) - alphabet);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out[n++] = (uint8_t)(w >> bits);
+        }
+    }
+    return n;
+}
+
+ZTEST(ts_codec, test_varint)
+{
+    static const uint32_t values[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152,
+                                       268435455, 268435456, UINT32_MAX };
+    static const size_t lens[] = { 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5 };
+    uint8_t buf[TS_CODEC_VARINT_MAX];
+    uint32_t v;
+
+    for (size_t i = 0; i < ARRAY_SIZE(values); i++) {
+        zassert_equal(ts_codec_varint_len(values[i]), lens[i], "len of %u", values[i]);
+        zassert_equal(ts_codec_put_varint(buf, values[i]), lens[i], "put of %u", values[i]);
+        zassert_equal(get_varint(buf, &v), lens[i]);
+        zassert_equal(v, values[i]);
+    }
+}
+
+ZTEST(ts_codec, test_zigzag)
+{
+    zassert_equal(ts_codec_zigzag(0), 0);
+    zassert_equal(ts_codec_zigzag(-1), 1);
+    zassert_equal(ts_codec_zigzag(1), 2);
+    zassert_equal(ts_codec_zigzag(-2), 3);
+    zassert_equal(ts_codec_zigzag(INT32_MAX), 0xFFFFFFFEu);
+    zassert_equal(ts_codec_zigzag(INT32_MIN), 0xFFFFFFFFu);
+}
+
+ZTEST(ts_codec, test_base64url)
+{
+    static const uint8_t url_chars[] = { 0xfb, 0xff };
+    char out[16];
+
+    zassert_equal(ts_codec_base64url((const uint8_t *)"", 0, out, sizeof(out)), 0);
+    zassert_equal(out[0], '\0');
+    zassert_equal(ts_codec_base64url((const uint8_t *)"f", 1, out, sizeof(out)), 2);
+    zassert_mem_equal(out, "Zg", 3);
+    zassert_equal(ts_codec_base64url((const uint8_t *)"fo", 2, out, sizeof(out)), 3);
+    zassert_mem_equal(out, "Zm8", 4);
+    zassert_equal(ts_codec_base64url((const uint8_t *)"foobar", 6, out, sizeof(out)), 8);
+    zassert_mem_equal(out, "Zm9vYmFy", 9);
+    zassert_equal(ts_codec_base64url(url_chars, 2, out, sizeof(out)), 3);
+    zassert_mem_equal(out, "-_8", 4);
+
+    /* no room for the text and its NUL */
+    zassert_equal(ts_codec_base64url((const uint8_t *)"foobar", 6, out, 8), 0);
+}
+
+ZTEST(ts_codec, test_entry)
+{
+    static const struct ts_codec_entry origin;
+    /* every delta at its widest: seq wraps by 2^16 - 1, ts by 2^32 - 1 */
+    static const struct ts_codec_entry worst = {
+        .ts = UINT32_MAX, .value = INT32_MIN, .seq = UINT16_MAX,
+    };
+    static const struct ts_codec_entry next = { .ts = 5000, .value = -3, .seq = 1 };
+    uint8_t out[TS_CODEC_ENTRY_MAX];
+
+    zassert_equal(ts_codec_put_entry(NULL, &origin, &worst), TS_CODEC_ENTRY_MAX);
+    zassert_equal(ts_codec_put_entry(out, &origin, &worst), TS_CODEC_ENTRY_MAX);
+
+    /* seq +1, ts +5000 (0x88 0x27), value -3 zig-zag mapped to 5 */
+    zassert_equal(ts_codec_put_entry(NULL, &origin, &next), 4);
+    zassert_equal(ts_codec_put_entry(out, &origin, &next), 4);
+    zassert_mem_equal(out, "\x01\x88\x27\x05", 4);
+}
+
+ZTEST(ts_codec, test_batch_round_trip)
+{
+    /* seq and uptime wrap, negative values and large jumps */
+    static const struct ts_codec_entry in[] = {
+        { .seq = 65534, .ts = 0xFFFFF000u, .value = 300 },
+        { .seq = 65535, .ts = 0xFFFFFFF0u, .value = -5 },
+        { .seq = 0, .ts = 0x00000400u, .value = -70000 },
+        { .seq = 3, .ts = 0x00001000u, .value = INT32_MAX / 2 },
+        { .seq = 4, .ts = 0x00002388u, .value = 0 },
+    };
+    uint8_t raw[ARRAY_SIZE(in) * TS_CODEC_ENTRY_MAX];
+    char text[TS_CODEC_BASE64_LEN(sizeof(raw)) + 1];
+    uint8_t back[sizeof(raw)];
+    struct ts_codec_entry out[ARRAY_SIZE(in)];
+    size_t len = encode_batch(in, ARRAY_SIZE(in), raw);
+    size_t chars = ts_codec_base64url(raw, len, text, sizeof(text));
+
+    zassert_equal(chars, TS_CODEC_BASE64_LEN(len));
+    zassert_equal(base64url_decode(text, back), len);
+    zassert_mem_equal(back, raw, len);
+    zassert_equal(decode_batch(back, len, out), ARRAY_SIZE(in));
+    for (size_t i = 0; i < ARRAY_SIZE(in); i++) {
+        zassert_equal(out[i].seq, in[i].seq, "reading %u", (unsigned int)i);
+        zassert_equal(out[i].ts, in[i].ts, "reading %u", (unsigned int)i);
+        zassert_equal(out[i].value, in[i].value, "reading %u", (unsigned int)i);
+    }
+}
+
+/* Smoke batches as the node sends them: a reading every ~5 s, small changes */
+ZTEST(ts_codec, test_bench_batch)
+{
+    struct ts_codec_entry r[BATCH_LEN];
+    uint8_t raw[BATCH_LEN * TS_CODEC_ENTRY_MAX];
+    char text[TS_CODEC_BASE64_LEN(sizeof(raw)) + 1];
+    char ascii[24];
+    uint32_t lfsr = 0xACE1u;
+    uint32_t raw_bytes = 0;
+    uint32_t chars = 0;
+    uint32_t ascii_chars = 0;
+    uint32_t ts = 120000;
+    int32_t value = 400;
+    uint16_t seq = 0;
+    uint64_t ns = 0;
+
+    for (int b = 0; b < BENCH_BATCHES; b++) {
+        uint64_t start;
+        size_t len;
+
+        for (int i = 0; i < BATCH_LEN; i++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+            ts += 5000 + (lfsr & 0x1f);
+            value += (int32_t)(lfsr >> 8 & 0x1f) - 16;
+            r[i] = (struct ts_codec_entry){ .ts = ts, .value = value, .seq = seq++ };
+            /* the "seq:uptime:value," triplets batches carried before */
+            ascii_chars += snprintf(ascii, sizeof(ascii), "%u:%u:%d,",
+                                    r[i].seq, r[i].ts, r[i].value);
+        }
+
+        start = bench_start();
+        len = encode_batch(r, BATCH_LEN, raw);
+        chars += ts_codec_base64url(raw, len, text, sizeof(text));
+        ns += bench_ns(start);
+        raw_bytes += len;
+    }
+
+    zassert_true(chars < ascii_chars);
+    TC_PRINT("batch of %d: %u.%02u bytes/sample encoded, %u.%02u chars/sample base64url, "
+             "%u.%02u chars/sample as text\n", BATCH_LEN,
+             raw_bytes / (BENCH_BATCHES * BATCH_LEN),
+             raw_bytes * 100 / (BENCH_BATCHES * BATCH_LEN) % 100,
+             chars / (BENCH_BATCHES * BATCH_LEN),
+             chars * 100 / (BENCH_BATCHES * BATCH_LEN) % 100,
+             ascii_chars / (BENCH_BATCHES * BATCH_LEN),
+             ascii_chars * 100 / (BENCH_BATCHES * BATCH_LEN) % 100);
+    bench_report("encode + base64url per sample", ns, BENCH_BATCHES * BATCH_LEN);
+}
+
+ZTEST_SUITE(ts_codec, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,119 @@
+#include <zephyr/ztest.h>
+
+#include "window_stats.h"
+
+#define ADC_RANGE 4096
+#define PPM_RANGE 5421      /* mq135_ppm_max() + 1 for the default CO2 table */
+
+static uint32_t bin_width(uint32_t range)
+{
+    return DIV_ROUND_UP(range, WINDOW_STATS_BINS);
+}
+
+ZTEST(window_stats, test_adc_counts)
+{
+    struct window_stats ws;
+    struct window_summary sum;
+
+    window_stats_init(&ws, ADC_RANGE);
+    for (int32_t v = 0; v < ADC_RANGE; v++) {
+        window_stats_add(&ws, v);
+    }
+    window_stats_summarize(&ws, 1000, &sum);
+
+    zassert_equal(sum.end_ms, 1000);
+    zassert_equal(sum.count, ADC_RANGE);
+    zassert_equal(sum.min, 0);
+    zassert_equal(sum.max, ADC_RANGE - 1);
+    zassert_equal(sum.mean, (ADC_RANGE - 1) / 2);
+    zassert_within(sum.p50, ADC_RANGE / 2, bin_width(ADC_RANGE), "p50 %d", sum.p50);
+    zassert_within(sum.p95, ADC_RANGE * 95 / 100, bin_width(ADC_RANGE), "p95 %d", sum.p95);
+    zassert_within(sum.p99, ADC_RANGE * 99 / 100, bin_width(ADC_RANGE), "p99 %d", sum.p99);
+}
+
+/* ppm summaries go past the 12-bit ADC range; the tail must not clamp at 4095 */
+ZTEST(window_stats, test_ppm_above_adc_range)
+{
+    struct window_stats ws;
+    struct window_summary sum;
+
+    window_stats_init(&ws, PPM_RANGE);
+    for (int i = 0; i < 90; i++) {
+        window_stats_add(&ws, 420);
+    }
+    for (int i = 0; i < 10; i++) {
+        window_stats_add(&ws, 5000);
+    }
+    window_stats_summarize(&ws, 0, &sum);
+
+    zassert_equal(sum.max, 5000);
+    zassert_within(sum.p50, 420, bin_width(PPM_RANGE), "p50 %d", sum.p50);
+    zassert_within(sum.p95, 5000, bin_width(PPM_RANGE), "p95 %d", sum.p95);
+    zassert_within(sum.p99, 5000, bin_width(PPM_RANGE), "p99 %d", sum.p99);
+    zassert_true(sum.p95 > ADC_RANGE - 1, "p95 %d clamped to the ADC range", sum.p95);
+}
+
+ZTEST(window_stats, test_range_kept_across_windows)
+{
+    struct window_stats ws;
+    struct window_summary sum;
+
+    window_stats_init(&ws, PPM_RANGE);
+    window_stats_add(&ws, 100);
+    window_stats_summarize(&ws, 0, &sum);
+
+    for (int i = 0; i < 20; i++) {
+        window_stats_add(&ws, 4800 + i);
+    }
+    window_stats_summarize(&ws, 0, &sum);
+    zassert_equal(sum.count, 20);
+    zassert_within(sum.p50, 4810, bin_width(PPM_RANGE), "p50 %d", sum.p50);
+    zassert_true(sum.p99 >= 4800 && sum.p99 <= 4819, "p99 %d", sum.p99);
+}
+
+ZTEST(window_stats, test_out_of_range_clamps)
+{
+    struct window_stats ws;
+    struct window_summary sum;
+
+    window_stats_init(&ws, ADC_RANGE);
+    window_stats_add(&ws, -50);
+    window_stats_add(&ws, 2000);
+    window_stats_add(&ws, 9000);
+    window_stats_summarize(&ws, 0, &sum);
+
+    /* edge bins hold them; percentiles stay inside what was seen */
+    zassert_equal(sum.min, -50);
+    zassert_equal(sum.max, 9000);
+    zassert_true(sum.p50 >= -50 && sum.p50 <= 9000, "p50 %d", sum.p50);
+    zassert_true(sum.p99 >= ADC_RANGE - (int32_t)bin_width(ADC_RANGE), "p99 %d", sum.p99);
+}
+
+ZTEST(window_stats, test_block_matches_single)
+{
+    /* two interleaved channels; the second is a ppm-like column */
+    int16_t scan[2 * 128];
+    struct window_stats by_block;
+    struct window_stats by_value;
+    struct window_summary a;
+    struct window_summary b;
+
+    for (size_t i = 0; i < ARRAY_SIZE(scan) / 2; i++) {
+        scan[2 * i] = (int16_t)(i * 37 % 101);
+        scan[2 * i + 1] = (int16_t)(400 + (i * 523 % 5000));
+    }
+
+    window_stats_init(&by_block, PPM_RANGE);
+    window_stats_init(&by_value, PPM_RANGE);
+    window_stats_add_block(&by_block, &scan[1], ARRAY_SIZE(scan) / 2, 2);
+    for (size_t i = 0; i < ARRAY_SIZE(scan) / 2; i++) {
+        window_stats_add(&by_value, scan[2 * i + 1]);
+    }
+    window_stats_summarize(&by_block, 0, &a);
+    window_stats_summarize(&by_value, 0, &b);
+
+    zassert_mem_equal(&a, &b, sizeof(a));
+    zassert_true(a.p99 > ADC_RANGE - 1, "p99 %d", a.p99);
+}
+
+ZTEST_SUITE(window_stats, NULL, NULL, NULL, NULL, NULL);
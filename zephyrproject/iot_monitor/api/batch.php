@@ -0,0 +1,111 @@
+<?php
+// api/batch.php
+require_once __DIR__ . '/../db.php';
+
+// GET parameters:
+//  - api_key (required)
+//  - sensor (required) air or flame
+//  - now (required) node uptime in ms when the request was built
+//  - z compact readings: base64url of LEB128 varints, per reading the seq
+//    delta, timestamp delta and zig-zag value delta to the previous one
+//  - d (instead of z) comma separated <seq>:<uptime_ms>:<value> readings
+//  - source (optional)
+
+$api_key = $_GET['api_key'] ?? null;
+$sensor = $_GET['sensor'] ?? null;
+$now = $_GET['now'] ?? null;
+$d = $_GET['d'] ?? null;
+$z = $_GET['z'] ?? null;
+$source = $_GET['source'] ?? null;
+
+if (!check_api_key($api_key)) {
+    http_response_code(401);
+    echo json_encode(['status' => 'error', 'message' => 'Invalid API key']);
+    exit;
+}
+
+$tables = [
+    'air' => "INSERT INTO air_quality (value, recorded_at, source) VALUES (:value, :recorded_at, :source)",
+    'flame' => "INSERT INTO flame_events (status, recorded_at, source) VALUES (:value, :recorded_at, :source)",
+];
+
+if ($sensor === null || !isset($tables[$sensor]) || $now === null || !ctype_digit($now) || ($d === null && $z === null)) {
+    http_response_code(400);
+    echo json_encode(['status' => 'error', 'message' => 'Missing or invalid sensor, now, z or d parameter']);
+    exit;
+}
+
+// Expand z into the same <seq>:<uptime_ms>:<value> list as d
+function decode_compact($z)
+{
+    $data = base64_decode(strtr($z, '-_', '+/'), true);
+    if ($data === false) {
+        return null;
+    }
+    $fields = [];
+    $value = 0;
+    $shift = 0;
+    for ($i = 0; $i < strlen($data); $i++) {
+        $b = ord($data[$i]);
+        $value |= ($b & 0x7f) << $shift;
+        $shift += 7;
+        if ($b < 0x80) {
+            $fields[] = $value;
+            $value = 0;
+            $shift = 0;
+        }
+    }
+    if ($shift !== 0 || count($fields) % 3 !== 0) {
+        return null;
+    }
+    $entries = [];
+    $seq = $ts = $val = 0;
+    for ($i = 0; $i < count($fields); $i += 3) {
+        $seq = ($seq + $fields[$i]) & 0xFFFF;
+        $ts = ($ts + $fields[$i + 1]) & 0xFFFFFFFF;
+        $val += ($fields[$i + 2] >> 1) ^ -($fields[$i + 2] & 1);
+        $entries[] = "$seq:$ts:$val";
+    }
+    return implode(',', $entries);
+}
+
+if ($z !== null) {
+    $d = decode_compact($z);
+    if ($d === null) {
+        http_response_code(400);
+        echo json_encode(['status' => 'error', 'message' => 'Invalid z parameter']);
+        exit;
+    }
+}
+
+// uptime stamps are turned into server time relative to "now"
+$received = time();
+$rows = [];
+foreach (explode(',', $d) as $entry) {
+    $parts = explode(':', $entry);
+    if (count($parts) !== 3 || !ctype_digit($parts[0]) || !ctype_digit($parts[1]) || !is_numeric($parts[2])) {
+        http_response_code(400);
+        echo json_encode(['status' => 'error', 'message' => 'Invalid reading: ' . $entry]);
+        exit;
+    }
+    $age_ms = ((int)$now - (int)$parts[1]) & 0xFFFFFFFF;
+    $rows[] = [
+        ':value' => (float)$parts[2],
+        ':recorded_at' => date('Y-m-d H:i:s', $received - intdiv($age_ms, 1000)),
+        ':source' => $source,
+    ];
+}
+
+try {
+    $pdo->beginTransaction();
+    $stmt = $pdo->prepare($tables[$sensor]);
+    foreach ($rows as $row) {
+        $stmt->execute($row);
+    }
+    $pdo->commit();
+    echo json_encode(['status' => 'ok', 'inserted' => count($rows)]);
+} catch (Exception $e) {
+    $pdo->rollBack();
+    http_response_code(500);
+    echo json_encode(['status' => 'error', 'message' => $e->getMessage()]);
+}
@@ -0,0 +1,58 @@
+<?php
+// api/summary.php
+require_once __DIR__ . '/../db.php';
+
+// GET parameters:
+//  - api_key (required)
+//  - sensor (required) air
+//  - now (required) node uptime in ms when the request was built
+//  - t (required) node uptime in ms when the window closed
+//  - n, min, max, mean, var, p50, p95, p99 (required) integer window summary
+//  - source (optional)
+//
+// The window mean is stored as the reading for that time, so the dashboard
+// keeps working unchanged; the full summary is echoed back.
+
+$api_key = $_GET['api_key'] ?? null;
+$sensor = $_GET['sensor'] ?? null;
+$source = $_GET['source'] ?? null;
+
+if (!check_api_key($api_key)) {
+    http_response_code(401);
+    echo json_encode(['status' => 'error', 'message' => 'Invalid API key']);
+    exit;
+}
+
+$fields = ['now', 't', 'n', 'min', 'max', 'mean', 'var', 'p50', 'p95', 'p99'];
+$summary = [];
+foreach ($fields as $f) {
+    $v = $_GET[$f] ?? null;
+    if ($v === null || !is_numeric($v)) {
+        http_response_code(400);
+        echo json_encode(['status' => 'error', 'message' => 'Missing or invalid ' . $f . ' parameter']);
+        exit;
+    }
+    $summary[$f] = (int)$v;
+}
+
+if ($sensor !== 'air') {
+    http_response_code(400);
+    echo json_encode(['status' => 'error', 'message' => 'Unsupported sensor']);
+    exit;
+}
+
+$age_ms = ($summary['now'] - $summary['t']) & 0xFFFFFFFF;
+$recorded_at = date('Y-m-d H:i:s', time() - intdiv($age_ms, 1000));
+
+try {
+    $stmt = $pdo->prepare("INSERT INTO air_quality (value, recorded_at, source) VALUES (:value, :recorded_at, :source)");
+    $stmt->execute([
+        ':value' => (float)$summary['mean'],
+        ':recorded_at' => $recorded_at,
+        ':source' => $source
+    ]);
+    echo json_encode(['status' => 'ok', 'inserted_id' => $pdo->lastInsertId(), 'summary' => $summary]);
+} catch (Exception $e) {
+    http_response_code(500);
+    echo json_encode(['status' => 'error', 'message' => $e->getMessage()]);
+}
@@ -236,7 +236,10 @@ $recentFlame = flame_in_last_minutes($pdo, 30);
 					<div class="card-body">
 						<p class="small">API endpoints (GET):</p>
 						<pre class="small">/api/air.php?api_key=YOUR_KEY&value=123.4
-/api/flame.php?api_key=YOUR_KEY&status=1</pre>
+/api/flame.php?api_key=YOUR_KEY&status=1
+/api/batch.php?api_key=YOUR_KEY&sensor=air&now=70000&d=1:10000:1200,2:15000:1300
+/api/batch.php?api_key=YOUR_KEY&sensor=air&now=70000&z=AZBO4BIBiCfIAQ
+/api/summary.php?api_key=YOUR_KEY&sensor=air&now=70000&t=65000&n=600&min=990&max=1210&mean=1040&var=210&p50=1035&p95=1120&p99=1190</pre>
 						<p class="small text-muted">Use your device / ESP AT commands to call the above URLs.</p>
 					</div>
 				</div>